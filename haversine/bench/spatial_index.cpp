@@ -0,0 +1,81 @@
+#include "haversine.hpp"
+#include "profile.hpp"
+#include "spatial_index.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Usage: IndexBench [num_points] [num_queries] [radius_km] [k]
+//
+// Brute force is only run for the first few queries; at 100M points a full
+// brute-force batch would take hours.
+static constexpr uint32_t BRUTE_FORCE_QUERIES = 8;
+
+auto random_points(std::mt19937 &gen, uint64_t n) -> std::vector<GeoPoint> {
+  TimeFunction;
+  std::uniform_real_distribution<double> lon(-180, 180);
+  std::uniform_real_distribution<double> lat(-90, 90);
+  std::vector<GeoPoint> points(n);
+  for (auto &p : points) {
+    p = {lon(gen), lat(gen)};
+  }
+  return points;
+}
+
+auto brute_force_radius(const std::vector<GeoPoint> &points, GeoPoint center,
+                        double distance) -> uint64_t {
+  TimeFunction;
+  uint64_t hits{};
+  for (auto &p : points) {
+    hits += haversine(center.x, center.y, p.x, p.y, EARTH_RADIUS) <= distance;
+  }
+  return hits;
+}
+
+auto brute_force_nearest(const std::vector<GeoPoint> &points, GeoPoint center)
+    -> double {
+  TimeFunction;
+  double best = 1e300;
+  for (auto &p : points) {
+    best =
+        std::min(best, haversine(center.x, center.y, p.x, p.y, EARTH_RADIUS));
+  }
+  return best;
+}
+
+int main(int argc, char *argv[]) {
+  begin_profile();
+  uint64_t num_points = argc > 1 ? atoll(argv[1]) : 1'000'000;
+  uint32_t num_queries = argc > 2 ? atoi(argv[2]) : 1000;
+  double distance = argc > 3 ? atof(argv[3]) : 100.0;
+  uint32_t k = argc > 4 ? atoi(argv[4]) : 10;
+  std::cout << "# Points: " << num_points << ", # Queries: " << num_queries
+            << ", Radius: " << distance << "km, k: " << k << std::endl;
+
+  std::mt19937 gen(1234);
+  auto points = random_points(gen, num_points);
+  auto centers = random_points(gen, num_queries);
+
+  SpatialIndex index(points);
+  std::filesystem::create_directories("data/");
+  index.save("data/bench.idx");
+  auto loaded = SpatialIndex::load("data/bench.idx");
+
+  auto radius_hits = loaded.radius_query(centers, distance);
+  auto nearest = loaded.knn_query(centers, k);
+
+  uint32_t mismatches{};
+  for (uint32_t i = 0; i < std::min(num_queries, BRUTE_FORCE_QUERIES); i++) {
+    auto hits = brute_force_radius(points, centers[i], distance);
+    mismatches += hits != radius_hits[i].size();
+    auto best = brute_force_nearest(points, centers[i]);
+    mismatches += !nearest[i].empty() && best != nearest[i][0].distance;
+  }
+  std::cout << "Brute force mismatches: " << mismatches << std::endl;
+
+  end_and_print_profile();
+}
@@ -0,0 +1,101 @@
+#include "arena.hpp"
+#include <algorithm>
+#include <new>
+#include <sys/mman.h>
+
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE 23
+#endif
+
+// Populated in slices so a destroyed arena stops its prefaulter promptly.
+static constexpr size_t PREFAULT_SLICE_BYTES = 64 * 1024 * 1024;
+
+static auto round_up(size_t n, size_t to) -> size_t {
+  return (n + to - 1) / to * to;
+}
+
+Arena::Arena(size_t capacity, ArenaOptions options,
+             std::pmr::memory_resource *upstream)
+    : capacity{round_up(std::max<size_t>(capacity, 1), HUGE_PAGE_BYTES)},
+      upstream{upstream} {
+  if (options.huge_pages == HugePages::Explicit) {
+    auto p = mmap(nullptr, this->capacity, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (p != MAP_FAILED) {
+      base = static_cast<char *>(p);
+      backing = HugePages::Explicit;
+    }
+  }
+
+  if (!base) {
+    // Over-reserve by one huge page and trim so the arena is 2MB aligned,
+    // which transparent huge pages need to back it.
+    auto reserve = this->capacity + HUGE_PAGE_BYTES;
+    auto p = mmap(nullptr, reserve, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (p == MAP_FAILED) {
+      throw std::bad_alloc();
+    }
+    auto raw = reinterpret_cast<uintptr_t>(p);
+    auto aligned = round_up(raw, HUGE_PAGE_BYTES);
+    if (aligned > raw) {
+      munmap(p, aligned - raw);
+    }
+    auto tail = raw + reserve - (aligned + this->capacity);
+    if (tail > 0) {
+      munmap(reinterpret_cast<void *>(aligned + this->capacity), tail);
+    }
+    base = reinterpret_cast<char *>(aligned);
+
+    if (options.huge_pages != HugePages::None &&
+        madvise(base, this->capacity, MADV_HUGEPAGE) == 0) {
+      backing = HugePages::Transparent;
+    }
+  }
+
+  // MADV_POPULATE_WRITE (Linux 5.14+) faults pages in without touching their
+  // contents, so it is safe while the owner is already writing to them. On
+  // older kernels it fails with EINVAL and the arena simply faults lazily.
+  if (options.prefault) {
+    prefaulter = std::jthread([this](std::stop_token stop) {
+      for (size_t offset = 0; offset < this->capacity && !stop.stop_requested();
+           offset += PREFAULT_SLICE_BYTES) {
+        auto len = std::min(PREFAULT_SLICE_BYTES, this->capacity - offset);
+        if (madvise(base + offset, len, MADV_POPULATE_WRITE) != 0) {
+          return;
+        }
+      }
+    });
+  }
+}
+
+Arena::~Arena() {
+  if (prefaulter.joinable()) {
+    prefaulter.request_stop();
+    prefaulter.join();
+  }
+  munmap(base, capacity);
+}
+
+auto Arena::do_allocate(size_t bytes, size_t alignment) -> void * {
+  auto start = round_up(used, alignment);
+  if (start + bytes > capacity) {
+    return upstream->allocate(bytes, alignment);
+  }
+  last = start;
+  used = start + bytes;
+  return base + start;
+}
+
+auto Arena::do_deallocate(void *p, size_t bytes, size_t alignment) -> void {
+  auto ptr = static_cast<char *>(p);
+  if (ptr < base || ptr >= base + capacity) {
+    upstream->deallocate(p, bytes, alignment);
+    return;
+  }
+  // Only the newest block can be returned, e.g. a scratch buffer that is
+  // released before anything else is allocated.
+  if (ptr == base + last && last + bytes == used) {
+    used = last;
+  }
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <stop_token>
+#include <thread>
+
+enum class HugePages {
+  None,
+  // madvise(MADV_HUGEPAGE) on a 2MB-aligned mapping.
+  Transparent,
+  // MAP_HUGETLB from the reserved pool; falls back to Transparent when the
+  // pool is empty or not configured.
+  Explicit,
+};
+
+struct ArenaOptions {
+  HugePages huge_pages{HugePages::Transparent};
+  // Populate the mapping on a background thread so first touch does not
+  // fault on the hot path.
+  bool prefault{false};
+};
+
+// Bump allocator over a single anonymous mapping reserved up front. Frees are
+// no-ops except for the most recent allocation; allocations past the
+// reservation spill to the upstream resource so an undersized estimate stays
+// correct, just slower. Pass it to pmr containers to pre-size large buffers
+// from a file size. Not thread safe; give each thread its own arena.
+class Arena : public std::pmr::memory_resource {
+  char *base{};
+  size_t capacity{};
+  size_t used{};
+  size_t last{};
+  HugePages backing{HugePages::None};
+  std::pmr::memory_resource *upstream{};
+  std::jthread prefaulter{};
+
+  auto do_allocate(size_t bytes, size_t alignment) -> void * override;
+  auto do_deallocate(void *p, size_t bytes, size_t alignment)
+      -> void override;
+  auto do_is_equal(const std::pmr::memory_resource &other) const noexcept
+      -> bool override {
+    return this == &other;
+  }
+
+public:
+  static constexpr size_t HUGE_PAGE_BYTES = 2 * 1024 * 1024;
+
+  explicit Arena(size_t capacity, ArenaOptions options = {},
+                 std::pmr::memory_resource *upstream =
+                     std::pmr::new_delete_resource());
+  ~Arena() override;
+  Arena(const Arena &) = delete;
+  auto operator=(const Arena &) -> Arena & = delete;
+
+  auto size() const -> size_t { return capacity; }
+  auto bytes_used() const -> size_t { return used; }
+  auto huge_pages() const -> HugePages { return backing; }
+  // Rewinds to empty but keeps the pages mapped, so reuse does not fault.
+  // Every container allocated from the arena must already be gone.
+  auto reset() -> void { used = last = 0; }
+};
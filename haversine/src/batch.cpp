@@ -0,0 +1,216 @@
+#include "batch.hpp"
+#include "profile.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+
+using Clock = std::chrono::steady_clock;
+
+struct BatchJob {
+  uint32_t file{};
+  uint32_t chunk{};
+  uint64_t begin{};
+  uint64_t end{};
+};
+
+struct ChunkResult {
+  RecordSum sum{};
+  Clock::time_point start{};
+  Clock::time_point end{};
+  std::string error{};
+};
+
+// Sums the records whose opening '{' lies in [begin, end). Records are flat
+// objects, as written by gen_data(), so the last one is completed by reading
+// past `end` up to its closing '}'; the next chunk skips that tail because it
+// only starts counting at its own first '{'.
+static auto sum_chunk(const std::string &path, uint64_t begin, uint64_t end,
+                      uint64_t file_size) -> RecordSum {
+  std::ifstream f(path, std::ios::binary);
+  if (!f) {
+    throw std::runtime_error("Could not open " + path);
+  }
+  std::string buf(end - begin, '\0');
+  f.seekg(static_cast<std::streamoff>(begin));
+  f.read(buf.data(), static_cast<std::streamsize>(buf.size()));
+
+  size_t first = 0;
+  if (begin == 0) {
+    auto open = buf.find('[');
+    if (open == std::string::npos) {
+      throw std::runtime_error("Expected points array in " + path);
+    }
+    first = open + 1;
+  }
+  auto start = buf.find('{', first);
+  if (start == std::string::npos) {
+    return {};
+  }
+
+  auto last = buf.rfind('{');
+  auto close = buf.find('}', last);
+  while (close == std::string::npos && end < file_size) {
+    auto more = std::min<uint64_t>(4096, file_size - end);
+    buf.resize(buf.size() + more);
+    f.read(buf.data() + buf.size() - more, static_cast<std::streamsize>(more));
+    end += more;
+    close = buf.find('}', last);
+  }
+  if (close == std::string::npos) {
+    throw std::runtime_error("Truncated record in " + path);
+  }
+  return sum_records(std::string_view(buf).substr(start, close + 1 - start));
+}
+
+auto collect_batch_paths(const std::vector<std::string> &args)
+    -> std::vector<std::string> {
+  std::vector<std::string> paths;
+  for (auto &arg : args) {
+    if (!std::filesystem::is_directory(arg)) {
+      paths.push_back(arg);
+      continue;
+    }
+    std::vector<std::string> found;
+    for (auto &entry : std::filesystem::directory_iterator(arg)) {
+      if (entry.is_regular_file() && entry.path().extension() == ".json") {
+        found.push_back(entry.path().string());
+      }
+    }
+    std::sort(found.begin(), found.end());
+    paths.insert(paths.end(), found.begin(), found.end());
+  }
+  return paths;
+}
+
+auto run_batch(const std::vector<std::string> &paths,
+               const BatchOptions &options) -> BatchResult {
+  TimeFunction;
+  auto batch_start = Clock::now();
+  auto chunk_bytes = std::max<uint64_t>(options.chunk_bytes, 1);
+
+  BatchResult result;
+  result.files.resize(paths.size());
+  std::vector<std::vector<ChunkResult>> chunks(paths.size());
+
+  // Split large files into one task per chunk and pack small files into
+  // tasks of about chunk_bytes. Tasks are queued largest file first, and the
+  // pool starts external submits in order, so the stragglers at the end of
+  // the batch are small.
+  std::vector<uint32_t> order;
+  for (uint32_t i = 0; i < paths.size(); i++) {
+    auto &file = result.files[i];
+    file.path = paths[i];
+    std::error_code ec;
+    file.bytes = std::filesystem::file_size(paths[i], ec);
+    if (ec) {
+      file.error = ec.message();
+      continue;
+    }
+    order.push_back(i);
+  }
+  std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+    return result.files[a].bytes > result.files[b].bytes;
+  });
+
+  std::vector<std::vector<BatchJob>> tasks;
+  std::vector<BatchJob> group;
+  uint64_t group_bytes{};
+  for (auto i : order) {
+    auto bytes = result.files[i].bytes;
+    if (bytes > chunk_bytes) {
+      auto n = static_cast<uint32_t>((bytes + chunk_bytes - 1) / chunk_bytes);
+      chunks[i].resize(n);
+      for (uint32_t c = 0; c < n; c++) {
+        auto begin = c * chunk_bytes;
+        tasks.push_back({{i, c, begin, std::min(begin + chunk_bytes, bytes)}});
+      }
+      continue;
+    }
+    chunks[i].resize(1);
+    group.push_back({i, 0, 0, bytes});
+    group_bytes += bytes;
+    if (group_bytes >= chunk_bytes) {
+      tasks.push_back(std::move(group));
+      group = {};
+      group_bytes = 0;
+    }
+  }
+  if (!group.empty()) {
+    tasks.push_back(std::move(group));
+  }
+
+  ThreadPool pool(options.num_threads);
+  for (auto &task : tasks) {
+    pool.submit([&, jobs = std::move(task)] {
+      for (auto &job : jobs) {
+        auto &out = chunks[job.file][job.chunk];
+        out.start = Clock::now();
+        try {
+          out.sum = sum_chunk(paths[job.file], job.begin, job.end,
+                              result.files[job.file].bytes);
+        } catch (const std::exception &e) {
+          out.error = e.what();
+        }
+        out.end = Clock::now();
+      }
+    });
+  }
+  pool.wait();
+
+  // Chunks are reduced in file order so sums do not depend on scheduling.
+  for (uint32_t i = 0; i < paths.size(); i++) {
+    auto &file = result.files[i];
+    if (chunks[i].empty()) {
+      continue;
+    }
+    auto first = chunks[i].front().start;
+    auto last = chunks[i].front().end;
+    for (auto &chunk : chunks[i]) {
+      file.total.sum += chunk.sum.sum;
+      file.total.count += chunk.sum.count;
+      first = std::min(first, chunk.start);
+      last = std::max(last, chunk.end);
+      if (file.error.empty()) {
+        file.error = chunk.error;
+      }
+    }
+    file.seconds = std::chrono::duration<double>(last - first).count();
+    if (file.error.empty()) {
+      result.bytes += file.bytes;
+      result.total.sum += file.total.sum;
+      result.total.count += file.total.count;
+    }
+  }
+  result.seconds =
+      std::chrono::duration<double>(Clock::now() - batch_start).count();
+  return result;
+}
+
+auto print_batch(const BatchResult &result) -> void {
+  for (auto &file : result.files) {
+    std::cout << file.path << ": ";
+    if (!file.error.empty()) {
+      std::cout << "error: " << file.error << std::endl;
+      continue;
+    }
+    std::cout << file.total.count << " points, average "
+              << std::setprecision(12)
+              << (file.total.count ? file.total.sum / file.total.count : 0.0)
+              << " (" << std::setprecision(4)
+              << static_cast<double>(file.bytes) / (1024 * 1024) << " MB in "
+              << file.seconds * 1000 << "ms)" << std::endl;
+  }
+
+  auto mb = static_cast<double>(result.bytes) / (1024 * 1024);
+  std::cout << "Batch: " << result.files.size() << " files, "
+            << result.total.count << " points, " << std::setprecision(4) << mb
+            << " MB in " << result.seconds * 1000 << "ms ("
+            << mb / result.seconds << " MB/s, "
+            << result.total.count / result.seconds << " points/s)"
+            << std::endl;
+}
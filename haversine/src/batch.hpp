@@ -0,0 +1,37 @@
+#pragma once
+
+#include "compute.hpp"
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct BatchOptions {
+  // Files larger than this are split into chunks of this size; smaller files
+  // are packed together into tasks of roughly this size.
+  uint64_t chunk_bytes{16 * 1024 * 1024};
+  uint32_t num_threads{std::thread::hardware_concurrency()};
+};
+
+struct FileResult {
+  std::string path{};
+  uint64_t bytes{};
+  RecordSum total{};
+  double seconds{};
+  std::string error{};
+};
+
+struct BatchResult {
+  std::vector<FileResult> files{};
+  uint64_t bytes{};
+  RecordSum total{};
+  double seconds{};
+};
+
+// Expands directories to the `.json` files directly inside them, sorted by
+// name; other arguments are taken as file paths.
+auto collect_batch_paths(const std::vector<std::string> &args)
+    -> std::vector<std::string>;
+auto run_batch(const std::vector<std::string> &paths,
+               const BatchOptions &options = {}) -> BatchResult;
+auto print_batch(const BatchResult &result) -> void;
@@ -0,0 +1,124 @@
+#include "compute.hpp"
+#include "arena.hpp"
+#include "haversine.hpp"
+#include "profile.hpp"
+#include "scanner.hpp"
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+
+auto to_point_pair(const JsonObject &obj) -> PointPair {
+  PointPair pair{};
+  for (auto &[k, v] : obj) {
+    auto coord = std::get<double>(v);
+    if (k == "x0")
+      pair.x0 = coord;
+    else if (k == "y0")
+      pair.y0 = coord;
+    else if (k == "x1")
+      pair.x1 = coord;
+    else if (k == "y1")
+      pair.y1 = coord;
+  }
+  return pair;
+}
+
+auto compute(const std::vector<JsonValue> &points) -> double {
+  double sum{};
+
+  TimeBandwidth(points.size() * sizeof(double) * 4 + points.size() * 8);
+
+  for (auto &v : points) {
+    auto pair = to_point_pair(std::get<JsonObject>(v));
+    sum += haversine(pair.x0, pair.y0, pair.x1, pair.y1, EARTH_RADIUS);
+  }
+  return sum;
+}
+
+// Scratch arenas up to this size stay mapped per thread between calls, so
+// repeated chunks reuse already-faulted pages; larger inputs get a one-off
+// arena that is unmapped afterwards. Kept small because pool workers in the
+// daemon live as long as the process and would otherwise pin this much each.
+static constexpr uint64_t MAX_RETAINED_SCRATCH_BYTES = 64 * 1024 * 1024;
+
+// One retained scratch arena per thread, shared by every record scan on it.
+static thread_local std::unique_ptr<Arena> scratch{};
+
+// An arena with room for scanning `records_bytes` of input: the thread's
+// scratch, rewound, or a fresh one held in `one_off` when it would not fit.
+static auto scratch_arena(uint64_t records_bytes,
+                          std::unique_ptr<Arena> &one_off) -> Arena * {
+  auto needed = Scanner::reserve_bytes(records_bytes);
+  if (needed > MAX_RETAINED_SCRATCH_BYTES) {
+    one_off = std::make_unique<Arena>(
+        needed, ArenaOptions{HugePages::Transparent, true});
+    return one_off.get();
+  }
+  if (!scratch || scratch->size() < needed) {
+    scratch = std::make_unique<Arena>(needed);
+  }
+  scratch->reset();
+  return scratch.get();
+}
+
+// Calls `f` with every top-level `{...}` record in `records`.
+static auto for_each_record(std::string_view records, auto &&f) -> void {
+  std::unique_ptr<Arena> one_off{};
+  auto *arena = scratch_arena(records.size(), one_off);
+
+  auto scanner = Scanner::from_source(records, arena);
+  auto &tokens = scanner.scan();
+
+  int i = 0;
+  while (i < static_cast<int>(tokens.size())) {
+    if (tokens[i].type != Token::LeftBrace) {
+      i++;
+      continue;
+    }
+    auto [next, value] = parse(tokens, i);
+    f(to_point_pair(std::get<JsonObject>(value)));
+    i = next;
+  }
+}
+
+auto sum_records(std::string_view records) -> RecordSum {
+  TimeBandwidth(records.size());
+  RecordSum result{};
+  for_each_record(records, [&](const PointPair &pair) {
+    result.sum += haversine(pair.x0, pair.y0, pair.x1, pair.y1, EARTH_RADIUS);
+    result.count++;
+  });
+  return result;
+}
+
+auto parse_records(std::string_view records,
+                   std::pmr::memory_resource *resource)
+    -> std::pmr::vector<PointPair> {
+  TimeBandwidth(records.size());
+  std::pmr::vector<PointPair> pairs(resource);
+  pairs.reserve(records.size() / BYTES_PER_RECORD + 1);
+  for_each_record(records,
+                  [&](const PointPair &pair) { pairs.push_back(pair); });
+  return pairs;
+}
+
+auto load_point_pairs(const std::string &path,
+                      std::pmr::memory_resource *resource)
+    -> std::pmr::vector<PointPair> {
+  auto size = std::filesystem::file_size(path);
+  TimeBandwidth(size);
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    throw std::runtime_error("Could not open " + path);
+  }
+  std::string contents(size, '\0');
+  file.read(contents.data(), static_cast<std::streamsize>(size));
+  contents.resize(static_cast<size_t>(file.gcount()));
+
+  auto open = contents.find('[');
+  if (open == std::string::npos) {
+    throw std::runtime_error("Expected points array in " + path);
+  }
+  return parse_records(std::string_view(contents).substr(open + 1), resource);
+}
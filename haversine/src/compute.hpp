@@ -0,0 +1,39 @@
+#pragma once
+
+#include "parser.hpp"
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct PointPair {
+  double x0{};
+  double y0{};
+  double x1{};
+  double y1{};
+};
+
+// Rough size of one gen_data() record, for sizing coordinate buffers from a
+// byte count.
+inline constexpr uint64_t BYTES_PER_RECORD = 64;
+
+struct RecordSum {
+  double sum{};
+  uint64_t count{};
+};
+
+auto to_point_pair(const JsonObject &obj) -> PointPair;
+auto compute(const std::vector<JsonValue> &points) -> double;
+// Sums every top-level `{...}` record in a buffer such as a slice of the
+// points array; separators and stray brackets between records are skipped.
+auto sum_records(std::string_view records) -> RecordSum;
+auto parse_records(std::string_view records,
+                   std::pmr::memory_resource *resource =
+                       std::pmr::get_default_resource())
+    -> std::pmr::vector<PointPair>;
+// Reads a whole `{"points": [...]}` file into flat coordinate records.
+auto load_point_pairs(const std::string &path,
+                      std::pmr::memory_resource *resource =
+                          std::pmr::get_default_resource())
+    -> std::pmr::vector<PointPair>;
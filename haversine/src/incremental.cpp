@@ -0,0 +1,123 @@
+#include "incremental.hpp"
+#include "profile.hpp"
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <stdexcept>
+
+// FNV-1a
+static auto hash_bytes(std::string_view bytes) -> uint64_t {
+  uint64_t hash = 14695981039346656037ull;
+  for (auto c : bytes) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+static auto read_range(std::ifstream &f, uint64_t begin, uint64_t end)
+    -> std::string {
+  std::string buf(end - begin, '\0');
+  f.clear();
+  f.seekg(static_cast<std::streamoff>(begin));
+  f.read(buf.data(), static_cast<std::streamsize>(buf.size()));
+  buf.resize(static_cast<size_t>(f.gcount()));
+  return buf;
+}
+
+static auto head_hash(std::ifstream &f, uint64_t offset) -> uint64_t {
+  return hash_bytes(read_range(f, 0, std::min(offset, CHECKPOINT_HASH_WINDOW)));
+}
+
+static auto tail_hash(std::ifstream &f, uint64_t offset) -> uint64_t {
+  return hash_bytes(
+      read_range(f, offset - std::min(offset, CHECKPOINT_HASH_WINDOW), offset));
+}
+
+auto checkpoint_path(const std::string &path) -> std::string {
+  return path + ".ckpt";
+}
+
+auto load_checkpoint(const std::string &path) -> std::optional<Checkpoint> {
+  std::ifstream f(checkpoint_path(path));
+  std::string version, sum;
+  Checkpoint c{};
+  if (!(f >> version >> c.offset >> c.total.count >> sum >> c.head_hash >>
+        c.tail_hash) ||
+      version != "v1") {
+    return std::nullopt;
+  }
+  auto [end, ec] =
+      std::from_chars(sum.data(), sum.data() + sum.size(), c.total.sum);
+  if (ec != std::errc{} || end != sum.data() + sum.size()) {
+    return std::nullopt;
+  }
+  return c;
+}
+
+auto save_checkpoint(const std::string &path, const Checkpoint &c) -> void {
+  // Write then rename so an interrupted run never leaves a torn sidecar.
+  auto target = checkpoint_path(path);
+  auto tmp = target + ".tmp";
+  {
+    std::ofstream f(tmp, std::ios::trunc);
+    f << std::format("v1 {} {} {} {} {}\n", c.offset, c.total.count,
+                     c.total.sum, c.head_hash, c.tail_hash);
+    if (!f) {
+      throw std::runtime_error("Could not write checkpoint " + tmp);
+    }
+  }
+  std::filesystem::rename(tmp, target);
+}
+
+auto sum_incremental(const std::string &path) -> IncrementalResult {
+  TimeFunction;
+  std::ifstream f(path, std::ios::binary);
+  if (!f) {
+    throw std::runtime_error("Could not open " + path);
+  }
+  auto size = std::filesystem::file_size(path);
+
+  IncrementalResult result{};
+  auto previous = load_checkpoint(path);
+  if (previous && previous->offset <= size &&
+      previous->head_hash == head_hash(f, previous->offset) &&
+      previous->tail_hash == tail_hash(f, previous->offset)) {
+    result.checkpoint = *previous;
+  } else {
+    result.full_rerun = true;
+  }
+
+  auto start = result.checkpoint.offset;
+  auto buf = read_range(f, start, size);
+  std::string_view records(buf);
+  if (start == 0) {
+    // Skip the `{"points": [` header; NDJSON has none.
+    auto open = records.find('[');
+    if (open != std::string_view::npos) {
+      records.remove_prefix(open + 1);
+    }
+  }
+  auto array_end = records.find(']');
+  if (array_end != std::string_view::npos) {
+    records = records.substr(0, array_end);
+  }
+
+  auto last = records.rfind('}');
+  if (last != std::string_view::npos) {
+    auto sum = sum_records(records.substr(0, last + 1));
+    result.new_records = sum.count;
+    result.checkpoint.total.sum += sum.sum;
+    result.checkpoint.total.count += sum.count;
+    result.checkpoint.offset =
+        start + static_cast<uint64_t>(records.data() - buf.data()) + last + 1;
+  }
+
+  auto &c = result.checkpoint;
+  c.head_hash = head_hash(f, c.offset);
+  c.tail_hash = tail_hash(f, c.offset);
+  save_checkpoint(path, c);
+  return result;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "compute.hpp"
+#include <cstdint>
+#include <optional>
+#include <string>
+
+// Bytes hashed at each end of the checkpointed prefix.
+static constexpr uint64_t CHECKPOINT_HASH_WINDOW = 4096;
+
+// Progress through an append-only point file, stored in a `.ckpt` sidecar.
+// The hashes cover the first and last CHECKPOINT_HASH_WINDOW bytes before
+// `offset`, so a rerun costs only the appended bytes. Known blind spot: an
+// edit that keeps the file length and falls entirely between those two
+// windows is not detected, and the saved sum goes stale until the sidecar is
+// deleted. Truncation, and any edit touching either window, forces a full
+// pass.
+struct Checkpoint {
+  // One past the closing '}' of the last record summed.
+  uint64_t offset{};
+  RecordSum total{};
+  uint64_t head_hash{};
+  uint64_t tail_hash{};
+};
+
+struct IncrementalResult {
+  Checkpoint checkpoint{};
+  uint64_t new_records{};
+  bool full_rerun{};
+};
+
+auto checkpoint_path(const std::string &path) -> std::string;
+auto load_checkpoint(const std::string &path) -> std::optional<Checkpoint>;
+auto save_checkpoint(const std::string &path, const Checkpoint &checkpoint)
+    -> void;
+// Sums only the records appended since the last checkpoint, falling back to a
+// full pass when the file no longer matches it. Works for both the
+// `{"points": [...]}` layout and NDJSON; an incomplete trailing record is
+// left for the next run.
+auto sum_incremental(const std::string &path) -> IncrementalResult;
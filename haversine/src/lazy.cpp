@@ -0,0 +1,396 @@
+#include "lazy.hpp"
+#include "profile.hpp"
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+// At most one structural entry per ~4 bytes of generated input.
+static constexpr uint64_t BYTES_PER_ENTRY = 4;
+
+static auto is_delimiter(char c) -> bool {
+  return c == ',' || c == ']' || c == '}' || c == ':' || c == ' ' ||
+         c == '\t' || c == '\n' || c == '\r';
+}
+
+static auto append_utf8(std::string &out, uint32_t cp) -> void {
+  if (cp < 0x80) {
+    out.push_back(static_cast<char>(cp));
+  } else if (cp < 0x800) {
+    out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+    out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+  } else if (cp < 0x10000) {
+    out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+    out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+  } else {
+    out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+    out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+  }
+}
+
+static auto parse_hex4(std::string_view s, size_t at) -> uint32_t {
+  uint32_t value{};
+  if (at + 4 > s.size() ||
+      std::from_chars(s.data() + at, s.data() + at + 4, value, 16).ptr !=
+          s.data() + at + 4) {
+    throw std::runtime_error("Invalid \\u escape");
+  }
+  return value;
+}
+
+// Decodes the characters between a string's quotes.
+static auto decode_string(std::string_view raw) -> std::string {
+  std::string out;
+  out.reserve(raw.size());
+  for (size_t i = 0; i < raw.size(); i++) {
+    if (raw[i] != '\\') {
+      out.push_back(raw[i]);
+      continue;
+    }
+    if (++i >= raw.size()) {
+      throw std::runtime_error("Invalid escape");
+    }
+    switch (raw[i]) {
+    case '"':
+    case '\\':
+    case '/':
+      out.push_back(raw[i]);
+      break;
+    case 'b':
+      out.push_back('\b');
+      break;
+    case 'f':
+      out.push_back('\f');
+      break;
+    case 'n':
+      out.push_back('\n');
+      break;
+    case 'r':
+      out.push_back('\r');
+      break;
+    case 't':
+      out.push_back('\t');
+      break;
+    case 'u': {
+      auto cp = parse_hex4(raw, i + 1);
+      i += 4;
+      if (cp >= 0xD800 && cp < 0xDC00 && i + 2 < raw.size() &&
+          raw[i + 1] == '\\' && raw[i + 2] == 'u') {
+        auto low = parse_hex4(raw, i + 3);
+        if (low >= 0xDC00 && low < 0xE000) {
+          cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+          i += 6;
+        }
+      }
+      // A surrogate left over here had no partner; it has no UTF-8 encoding.
+      if (cp >= 0xD800 && cp < 0xE000) {
+        throw std::runtime_error("Unpaired surrogate in \\u escape");
+      }
+      append_utf8(out, cp);
+      break;
+    }
+    default:
+      throw std::runtime_error("Invalid escape");
+    }
+  }
+  return out;
+}
+
+LazyDocument::LazyDocument(const std::string &path,
+                           std::pmr::memory_resource *resource)
+    : LazyDocument(resource) {
+  auto size = std::filesystem::file_size(path);
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    throw std::runtime_error("Could not open " + path);
+  }
+  contents.resize(size);
+  file.read(contents.data(), static_cast<std::streamsize>(size));
+  contents.resize(static_cast<size_t>(file.gcount()));
+  build();
+}
+
+auto LazyDocument::from_source(std::string_view source,
+                               std::pmr::memory_resource *resource)
+    -> LazyDocument {
+  LazyDocument doc(resource);
+  doc.contents.assign(source.begin(), source.end());
+  doc.build();
+  return doc;
+}
+
+auto LazyDocument::reserve_bytes(uint64_t source_bytes) -> uint64_t {
+  return source_bytes +
+         (source_bytes / BYTES_PER_ENTRY + 1) * sizeof(Structural) + 4096;
+}
+
+// Only nesting, strings and scalar extents are checked here; anything else
+// malformed surfaces when the offending value is accessed.
+auto LazyDocument::build() -> void {
+  TimeBandwidth(contents.size());
+  struct Frame {
+    uint64_t opener{};
+    uint64_t commas{};
+    bool nonempty{};
+  };
+  std::vector<Frame> stack;
+  entries.reserve(contents.size() / BYTES_PER_ENTRY + 1);
+
+  auto mark_value = [&] {
+    if (!stack.empty()) {
+      stack.back().nonempty = true;
+    }
+  };
+
+  uint64_t i = 0;
+  auto n = contents.size();
+  while (i < n) {
+    auto c = contents[i];
+    switch (c) {
+    case ' ':
+    case '\t':
+    case '\n':
+    case '\r':
+      i++;
+      break;
+    case '{':
+    case '[':
+      mark_value();
+      stack.push_back({entries.size(), 0, false});
+      entries.push_back({i, 0});
+      i++;
+      break;
+    case '}':
+    case ']': {
+      auto open = c == '}' ? '{' : '[';
+      if (stack.empty() ||
+          contents[entries[stack.back().opener].offset] != open) {
+        throw std::runtime_error(std::string("Unexpected '") + c + "'");
+      }
+      auto frame = stack.back();
+      stack.pop_back();
+      entries.push_back({i, frame.nonempty ? frame.commas + 1 : 0});
+      entries[frame.opener].next = entries.size();
+      i++;
+      break;
+    }
+    case ',':
+      if (!stack.empty()) {
+        stack.back().commas++;
+      }
+      [[fallthrough]];
+    case ':':
+      entries.push_back({i, entries.size() + 1});
+      i++;
+      break;
+    case '"':
+      mark_value();
+      entries.push_back({i, entries.size() + 1});
+      i++;
+      while (i < n && contents[i] != '"') {
+        i += contents[i] == '\\' ? 2 : 1;
+      }
+      if (i >= n) {
+        throw std::runtime_error("Unterminated string");
+      }
+      i++;
+      break;
+    default:
+      if (c != '-' && c != 't' && c != 'f' && c != 'n' &&
+          (c < '0' || c > '9')) {
+        throw std::runtime_error(std::string("Unexpected character '") + c +
+                                 "'");
+      }
+      mark_value();
+      entries.push_back({i, entries.size() + 1});
+      while (i < n && !is_delimiter(contents[i])) {
+        i++;
+      }
+    }
+  }
+
+  if (!stack.empty()) {
+    throw std::runtime_error("Unterminated container");
+  }
+  if (entries.empty()) {
+    throw std::runtime_error("Empty document");
+  }
+}
+
+auto LazyValue::type() const -> Type {
+  switch (doc->contents[doc->entries[idx].offset]) {
+  case '{':
+    return Type::Object;
+  case '[':
+    return Type::Array;
+  case '"':
+    return Type::String;
+  case 't':
+  case 'f':
+    return Type::Bool;
+  case 'n':
+    return Type::Null;
+  case ',':
+  case ':':
+  case '}':
+  case ']':
+    throw std::runtime_error("Expected a value");
+  default:
+    return Type::Number;
+  }
+}
+
+// Source bytes of a scalar; for strings, the part between the quotes.
+auto LazyValue::raw() const -> std::string_view {
+  auto &contents = doc->contents;
+  auto start = doc->entries[idx].offset;
+  auto end = start;
+  if (contents[start] == '"') {
+    start++;
+    end = start;
+    while (contents[end] != '"') {
+      end += contents[end] == '\\' ? 2 : 1;
+    }
+  } else {
+    while (end < contents.size() && !is_delimiter(contents[end])) {
+      end++;
+    }
+  }
+  return {contents.data() + start, end - start};
+}
+
+auto LazyValue::get_double() const -> double {
+  if (type() != Type::Number) {
+    throw std::runtime_error("Expected a number");
+  }
+  auto s = raw();
+  double value{};
+  auto [end, ec] = std::from_chars(s.data(), s.data() + s.size(), value);
+  if (ec != std::errc{} || end != s.data() + s.size()) {
+    throw std::runtime_error("Invalid number: " + std::string(s));
+  }
+  return value;
+}
+
+auto LazyValue::get_string() const -> std::string {
+  if (type() != Type::String) {
+    throw std::runtime_error("Expected a string");
+  }
+  return decode_string(raw());
+}
+
+auto LazyValue::get_bool() const -> bool {
+  if (type() != Type::Bool) {
+    throw std::runtime_error("Expected a bool");
+  }
+  auto s = raw();
+  if (s != "true" && s != "false") {
+    throw std::runtime_error("Invalid literal: " + std::string(s));
+  }
+  return s == "true";
+}
+
+auto LazyValue::is_null() const -> bool {
+  return type() == Type::Null && raw() == "null";
+}
+
+auto LazyValue::size() const -> uint64_t {
+  auto t = type();
+  if (t != Type::Object && t != Type::Array) {
+    throw std::runtime_error("Expected a container");
+  }
+  return doc->entries[doc->entries[idx].next - 1].next;
+}
+
+auto LazyValue::find(std::string_view key) const -> std::optional<LazyValue> {
+  if (type() != Type::Object) {
+    throw std::runtime_error("Expected an object");
+  }
+  auto &entries = doc->entries;
+  auto end = entries[idx].next - 1;
+  auto i = idx + 1;
+  while (i < end) {
+    LazyValue k{doc, i};
+    if (k.type() != Type::String || i + 2 >= end ||
+        doc->contents[entries[i + 1].offset] != ':') {
+      throw std::runtime_error("Expected \"key\": value");
+    }
+    auto name = k.raw();
+    auto matches = name.find('\\') == std::string_view::npos
+                       ? name == key
+                       : decode_string(name) == key;
+    if (matches) {
+      return LazyValue{doc, i + 2};
+    }
+    i = entries[i + 2].next;
+    if (i < end && doc->contents[entries[i].offset] == ',') {
+      i++;
+    }
+  }
+  return std::nullopt;
+}
+
+auto LazyValue::operator[](std::string_view key) const -> LazyValue {
+  auto value = find(key);
+  if (!value) {
+    throw std::runtime_error("No such key: " + std::string(key));
+  }
+  return *value;
+}
+
+auto LazyValue::at(uint64_t n) const -> LazyValue {
+  if (type() != Type::Array) {
+    throw std::runtime_error("Expected an array");
+  }
+  if (n >= size()) {
+    throw std::runtime_error("Index out of range: " + std::to_string(n));
+  }
+  auto &entries = doc->entries;
+  auto i = idx + 1;
+  for (uint64_t skipped = 0; skipped < n; skipped++) {
+    i = entries[i].next + 1;
+  }
+  return {doc, i};
+}
+
+auto LazyValue::at_pointer(std::string_view pointer) const -> LazyValue {
+  TimeFunction;
+  auto value = *this;
+  while (!pointer.empty()) {
+    if (pointer[0] != '/') {
+      throw std::runtime_error("JSON pointer must start with '/'");
+    }
+    pointer.remove_prefix(1);
+    auto slash = pointer.find('/');
+    auto token = pointer.substr(0, slash);
+    pointer = slash == std::string_view::npos ? std::string_view{}
+                                              : pointer.substr(slash);
+
+    std::string name;
+    for (size_t i = 0; i < token.size(); i++) {
+      if (token[i] == '~' && i + 1 < token.size() &&
+          (token[i + 1] == '0' || token[i + 1] == '1')) {
+        name.push_back(token[++i] == '0' ? '~' : '/');
+      } else {
+        name.push_back(token[i]);
+      }
+    }
+
+    if (value.type() == Type::Array) {
+      uint64_t n{};
+      auto last = name.data() + name.size();
+      auto [end, ec] = std::from_chars(name.data(), last, n);
+      if (name.empty() || ec != std::errc{} || end != last) {
+        throw std::runtime_error("Invalid array index: " + name);
+      }
+      value = value.at(n);
+    } else {
+      value = value[name];
+    }
+  }
+  return value;
+}
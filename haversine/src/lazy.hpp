@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class LazyDocument;
+
+// Cursor onto one value of a LazyDocument. Nothing is decoded until asked
+// for: numbers and strings are converted on access, and walking past a
+// container jumps straight to its matching close.
+class LazyValue {
+  const LazyDocument *doc{};
+  uint64_t idx{};
+
+  auto raw() const -> std::string_view;
+
+public:
+  enum class Type { Object, Array, String, Number, Bool, Null };
+
+  LazyValue(const LazyDocument *doc, uint64_t idx) : doc{doc}, idx{idx} {}
+
+  auto type() const -> Type;
+  auto get_double() const -> double;
+  auto get_string() const -> std::string;
+  auto get_bool() const -> bool;
+  auto is_null() const -> bool;
+  // Element or member count of a container, counted while indexing.
+  auto size() const -> uint64_t;
+
+  auto find(std::string_view key) const -> std::optional<LazyValue>;
+  auto operator[](std::string_view key) const -> LazyValue;
+  auto at(uint64_t i) const -> LazyValue;
+  // RFC 6901 JSON pointer relative to this value, e.g. "/points/3/x0".
+  auto at_pointer(std::string_view pointer) const -> LazyValue;
+};
+
+// A JSON file plus its structural index: one entry per structural character
+// and per scalar, each knowing where the value it starts ends. Building the
+// index is one pass over the bytes; every lookup after that only touches the
+// entries on its path.
+class LazyDocument {
+  friend class LazyValue;
+
+  struct Structural {
+    uint64_t offset{};
+    // Index one past the end of the value starting here. For '}' and ']'
+    // entries this holds the container's element count instead.
+    uint64_t next{};
+  };
+
+  std::pmr::vector<char> contents;
+  std::pmr::vector<Structural> entries;
+
+  explicit LazyDocument(std::pmr::memory_resource *resource)
+      : contents{resource}, entries{resource} {}
+  auto build() -> void;
+
+public:
+  LazyDocument(const std::string &path, std::pmr::memory_resource *resource =
+                                            std::pmr::get_default_resource());
+  static auto from_source(std::string_view source,
+                          std::pmr::memory_resource *resource =
+                              std::pmr::get_default_resource())
+      -> LazyDocument;
+  // Upper estimate of what indexing `source_bytes` of input allocates.
+  static auto reserve_bytes(uint64_t source_bytes) -> uint64_t;
+
+  auto root() const -> LazyValue { return {this, 0}; }
+  auto at_pointer(std::string_view pointer) const -> LazyValue {
+    return root().at_pointer(pointer);
+  }
+};
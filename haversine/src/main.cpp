@@ -1,46 +1,158 @@
+#include "arena.hpp"
+#include "batch.hpp"
+#include "compute.hpp"
 #include "generator.hpp"
-#include "haversine.hpp"
+#include "incremental.hpp"
+#include "lazy.hpp"
+#include "ndjson.hpp"
 #include "parser.hpp"
 #include "profile.hpp"
 #include "scanner.hpp"
+#include "server.hpp"
 #include <cstdint>
 #include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
 #include <iomanip>
 #include <iostream>
 #include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 #include <vector>
 
-auto compute(const auto &points) -> double {
-  double sum{};
-
-  TimeBandwidth(points.size() * sizeof(double) * 4 + points.size() * 8);
-
-  for (auto &v : points) {
-    auto obj = std::get<JsonObject>(v);
-    std::vector<double> coords(4);
-    for (auto &[k, v] : obj) {
-      int i{};
-      if (k == "y0")
-        i = 1;
-      else if (k == "x1")
-        i = 2;
-      else if (k == "y1")
-        i = 3;
-      coords[i] = (std::get<double>(v));
+int main(int argc, char *argv[]) {
+  begin_profile();
+  if (argc > 1 && std::string_view(argv[1]) == "--batch") {
+    auto paths =
+        collect_batch_paths(std::vector<std::string>(argv + 2, argv + argc));
+    print_batch(run_batch(paths));
+    end_and_print_profile();
+    return 0;
+  }
+  if (argc > 2 && std::string_view(argv[1]) == "--ndjson") {
+    NdjsonOptions options{};
+    options.follow = argc > 3 && std::string_view(argv[3]) == "--follow";
+    std::function<void(const RecordSum &)> on_progress{};
+    if (options.follow) {
+      on_progress = [](const RecordSum &total) {
+        std::cout << "Running Average Sum: " << std::setprecision(12)
+                  << (total.count ? total.sum / total.count : 0.0) << " ("
+                  << total.count << " points)" << std::endl;
+      };
+    }
+
+    std::ifstream file;
+    auto from_stdin = std::string_view(argv[2]) == "-";
+    if (from_stdin) {
+      // Gives std::cin a buffered fd reader, so readsome() sees what a pipe
+      // has delivered so far.
+      std::ios::sync_with_stdio(false);
+    } else {
+      file.open(argv[2], std::ios::binary);
+      if (!file) {
+        std::cerr << "Could not open " << argv[2] << std::endl;
+        return 1;
+      }
     }
-    sum += haversine(coords[0], coords[1], coords[2], coords[3], EARTH_RADIUS);
+    auto &in = from_stdin ? std::cin : static_cast<std::istream &>(file);
+    try {
+      auto total = sum_ndjson(in, options, on_progress);
+      std::cout << "Computed Average Sum: " << std::setprecision(12)
+                << (total.count ? total.sum / total.count : 0.0) << std::endl;
+    } catch (const std::exception &e) {
+      std::cerr << argv[2] << ": " << e.what() << std::endl;
+      return 1;
+    }
+    end_and_print_profile();
+    return 0;
+  }
+  if (argc > 2 && std::string_view(argv[1]) == "--incremental") {
+    int status = 0;
+    for (int i = 2; i < argc; i++) {
+      try {
+        auto result = sum_incremental(argv[i]);
+        auto &total = result.checkpoint.total;
+        std::cout << argv[i] << ": " << total.count << " points (+"
+                  << result.new_records
+                  << (result.full_rerun ? ", full pass" : ", appended")
+                  << "), Computed Average Sum: " << std::setprecision(12)
+                  << (total.count ? total.sum / total.count : 0.0)
+                  << std::endl;
+      } catch (const std::exception &e) {
+        std::cerr << argv[i] << ": " << e.what() << std::endl;
+        status = 1;
+      }
+    }
+    end_and_print_profile();
+    return status;
+  }
+  if (argc > 3 && std::string_view(argv[1]) == "--query") {
+    try {
+      auto size = std::filesystem::file_size(argv[2]);
+      Arena arena(LazyDocument::reserve_bytes(size),
+                  {HugePages::Transparent, true});
+      LazyDocument doc(argv[2], &arena);
+      auto value = doc.at_pointer(argv[3]);
+      switch (value.type()) {
+      case LazyValue::Type::Object:
+        std::cout << "object of " << value.size() << " members" << std::endl;
+        break;
+      case LazyValue::Type::Array:
+        std::cout << "array of " << value.size() << " elements" << std::endl;
+        break;
+      case LazyValue::Type::String:
+        std::cout << value.get_string() << std::endl;
+        break;
+      case LazyValue::Type::Number:
+        std::cout << std::setprecision(17) << value.get_double() << std::endl;
+        break;
+      case LazyValue::Type::Bool:
+        std::cout << (value.get_bool() ? "true" : "false") << std::endl;
+        break;
+      case LazyValue::Type::Null:
+        if (!value.is_null()) {
+          throw std::runtime_error(std::string("Invalid literal at ") +
+                                   argv[3]);
+        }
+        std::cout << "null" << std::endl;
+        break;
+      }
+    } catch (const std::exception &e) {
+      std::cerr << argv[2] << ": " << e.what() << std::endl;
+      return 1;
+    }
+    end_and_print_profile();
+    return 0;
+  }
+  if (argc > 2 && std::string_view(argv[1]) == "--serve") {
+    try {
+      run_server({argv[2]});
+    } catch (const std::exception &e) {
+      std::cerr << argv[2] << ": " << e.what() << std::endl;
+      return 1;
+    }
+    return 0;
   }
-  return sum;
-}
 
-int main(int argc, char *argv[]) {
-  begin_profile();
   uint32_t num_points = atoi(argv[1]);
   std::cout << "# Points: " << num_points << std::endl;
 
+  // Optional second argument selects the page size backing the scan buffers.
+  auto huge_pages = HugePages::Transparent;
+  if (argc > 2 && std::string_view(argv[2]) == "none") {
+    huge_pages = HugePages::None;
+  } else if (argc > 2 && std::string_view(argv[2]) == "explicit") {
+    huge_pages = HugePages::Explicit;
+  }
+
   auto path = gen_data(num_points);
-  Scanner s(path);
-  auto tokens = s.scan();
+  Arena arena(Scanner::reserve_bytes(std::filesystem::file_size(path)),
+              {huge_pages, true});
+  Scanner s(path, &arena);
+  auto &tokens = s.scan();
 
   auto obj = parse(tokens);
 
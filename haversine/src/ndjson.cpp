@@ -0,0 +1,128 @@
+#include "ndjson.hpp"
+#include "profile.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Blocks smaller than this per thread are not worth splitting further.
+static constexpr uint64_t MIN_CHUNK_BYTES = 64 * 1024;
+
+// Blocks only until the first byte arrives, then takes whatever else the
+// stream already has buffered, so a slow pipe yields its lines as they come
+// instead of once `n` bytes have accumulated.
+static auto read_available(std::istream &in, char *out, uint64_t n)
+    -> uint64_t {
+  if (in.peek() == std::char_traits<char>::eof()) {
+    return 0;
+  }
+  uint64_t got{};
+  while (got < n) {
+    auto k = in.readsome(out + got, static_cast<std::streamsize>(n - got));
+    if (k <= 0) {
+      break;
+    }
+    got += static_cast<uint64_t>(k);
+  }
+  // Unbuffered streams report nothing available past the peeked byte.
+  if (got == 0 && in.get(*out)) {
+    got = 1;
+  }
+  return got;
+}
+
+auto sum_ndjson(std::istream &in, const NdjsonOptions &options,
+                const std::function<void(const RecordSum &)> &on_progress,
+                std::stop_token stop) -> RecordSum {
+  TimeFunction;
+  auto block_bytes = std::max<uint64_t>(options.block_bytes, 1);
+
+  RecordSum total{};
+  std::string parsing;
+  std::vector<RecordSum> partials;
+  bool busy = false;
+  // Declared after the buffers its tasks reference so it drains first.
+  ThreadPool pool(options.num_threads);
+
+  auto finish = [&] {
+    if (!busy) {
+      return;
+    }
+    pool.wait();
+    for (auto &partial : partials) {
+      total.sum += partial.sum;
+      total.count += partial.count;
+    }
+    busy = false;
+    if (on_progress) {
+      on_progress(total);
+    }
+  };
+
+  std::string carry;
+  while (!stop.stop_requested()) {
+    std::string block = std::move(carry);
+    carry.clear();
+    auto old_size = block.size();
+    block.resize(old_size + block_bytes);
+    if (in.rdbuf()->in_avail() <= 0) {
+      // Nothing buffered: report the block in flight before waiting on input.
+      finish();
+    }
+    auto n = read_available(in, block.data() + old_size, block_bytes);
+    block.resize(old_size + n);
+
+    if (n == 0) {
+      if (in.bad() || !in.eof()) {
+        throw std::runtime_error("Failed reading NDJSON input");
+      }
+      finish();
+      if (options.follow) {
+        carry = std::move(block);
+        in.clear();
+        std::this_thread::sleep_for(options.poll_interval);
+        continue;
+      }
+      // A final line without a trailing newline.
+      if (block.find('{') != std::string::npos) {
+        auto last = sum_records(block);
+        total.sum += last.sum;
+        total.count += last.count;
+        if (on_progress) {
+          on_progress(total);
+        }
+      }
+      break;
+    }
+
+    auto cut = block.rfind('\n');
+    if (cut == std::string::npos) {
+      carry = std::move(block);
+      continue;
+    }
+    carry = block.substr(cut + 1);
+    block.resize(cut + 1);
+
+    // Wait for the previous block only now, so its parse overlapped this read.
+    finish();
+    parsing = std::move(block);
+
+    auto chunks = std::clamp<uint64_t>(parsing.size() / MIN_CHUNK_BYTES, 1,
+                                       pool.size());
+    partials.assign(chunks, {});
+    size_t begin = 0;
+    for (uint64_t i = 0; i < chunks && begin < parsing.size(); i++) {
+      auto nominal = std::max<size_t>(begin, (i + 1) * parsing.size() / chunks);
+      auto end = i + 1 == chunks ? parsing.size() - 1
+                                 : parsing.find('\n', nominal);
+      auto lines = std::string_view(parsing).substr(begin, end + 1 - begin);
+      pool.submit([&partials, lines, i] { partials[i] = sum_records(lines); });
+      begin = end + 1;
+    }
+    busy = true;
+  }
+  finish();
+  return total;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "compute.hpp"
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <stop_token>
+#include <thread>
+
+struct NdjsonOptions {
+  // Most bytes read per step; a step takes only what is already available
+  // once the first byte arrives. Each block is cut at its last newline and
+  // the complete lines are split across the pool.
+  uint64_t block_bytes{8 * 1024 * 1024};
+  uint32_t num_threads{std::thread::hardware_concurrency()};
+  // Keep polling at end of input for appended lines, like `tail -f`.
+  bool follow{false};
+  std::chrono::milliseconds poll_interval{100};
+};
+
+// Sums a stream with one {"x0":..,"y0":..,"x1":..,"y1":..} object per line.
+// The next block is read while the previous one is being parsed, and
+// `on_progress` sees the running total after every block. In follow mode a
+// trailing partial line is held back until its newline arrives, and the call
+// only returns once `stop` is requested.
+auto sum_ndjson(std::istream &in, const NdjsonOptions &options = {},
+                const std::function<void(const RecordSum &)> &on_progress = {},
+                std::stop_token stop = {}) -> RecordSum;
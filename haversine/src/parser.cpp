@@ -5,7 +5,8 @@
 #include <string>
 #include <utility>
 
-auto parse(std::vector<Token> &tokens, int start) -> std::pair<int, JsonValue> {
+auto parse(std::pmr::vector<Token> &tokens, int start)
+    -> std::pair<int, JsonValue> {
   if (start >= tokens.size()) {
     throw std::runtime_error("Unexpected end of input");
   }
@@ -41,7 +42,8 @@ auto parse(std::vector<Token> &tokens, int start) -> std::pair<int, JsonValue> {
 
       if (current < tokens.size() && tokens[current].type == Token::Comma) {
         current++;
-      } else if (tokens[current].type != Token::RightBracket) {
+      } else if (current < tokens.size() &&
+                 tokens[current].type != Token::RightBracket) {
         throw std::runtime_error("Expected ',' or ']'");
       }
     }
@@ -76,7 +78,8 @@ auto parse(std::vector<Token> &tokens, int start) -> std::pair<int, JsonValue> {
 
       if (current < tokens.size() && tokens[current].type == Token::Comma) {
         current++;
-      } else if (tokens[current].type != Token::RightBrace) {
+      } else if (current < tokens.size() &&
+                 tokens[current].type != Token::RightBrace) {
         throw std::runtime_error("Expected ',' or '}'");
       }
     }
@@ -92,7 +95,7 @@ auto parse(std::vector<Token> &tokens, int start) -> std::pair<int, JsonValue> {
   }
 }
 
-auto parse(std::vector<Token> &tokens) -> JsonObject {
+auto parse(std::pmr::vector<Token> &tokens) -> JsonObject {
   TimeFunction;
   if (tokens.empty()) {
     return JsonObject{};
@@ -4,6 +4,7 @@
 #include <cstdint>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -18,4 +19,8 @@ struct JsonValue
                std::vector<JsonValue>, JsonObject>
       value;
 };
-auto parse(std::vector<Token> &tokens) -> JsonObject;
+auto parse(std::pmr::vector<Token> &tokens) -> JsonObject;
+// Parses the single value starting at tokens[start]; returns the index one
+// past it.
+auto parse(std::pmr::vector<Token> &tokens, int start)
+    -> std::pair<int, JsonValue>;
@@ -1,12 +1,16 @@
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <cstdint>
 #include <iomanip>
 #include <iostream>
 #include <ostream>
 #include <string_view>
+#include <sys/resource.h>
 #include <thread>
+#include <vector>
 #include <x86intrin.h>
 
 inline auto rdtsc() -> uint64_t {
@@ -21,7 +25,7 @@ inline auto rdtsc() -> uint64_t {
   return start_cycles;
 }
 
-inline auto get_cpu_frequency() -> uint64_t {
+inline auto measure_cpu_frequency() -> uint64_t {
   using namespace std::literals::chrono_literals;
 
   auto start_time = std::chrono::high_resolution_clock::now();
@@ -36,24 +40,44 @@ inline auto get_cpu_frequency() -> uint64_t {
   return static_cast<uint64_t>((cycles * 10) / duration.count());
 }
 
+// Measured once per process: the measurement sleeps for 100ms.
+inline auto get_cpu_frequency() -> uint64_t {
+  static const uint64_t freq = measure_cpu_frequency();
+  return freq;
+}
+
+// Minor + major page faults taken so far by the calling thread, or by the
+// whole process (always the case where per-thread usage is unavailable).
+inline auto page_faults(bool whole_process = false) -> uint64_t {
+  rusage usage{};
+#if defined(__linux__) || defined(__linux) || defined(linux)
+  getrusage(whole_process ? RUSAGE_SELF : RUSAGE_THREAD, &usage);
+#else
+  getrusage(RUSAGE_SELF, &usage);
+#endif
+  return static_cast<uint64_t>(usage.ru_minflt + usage.ru_majflt);
+}
+
 struct ProfileAnchor {
   uint64_t tsc_elapsed{};
   uint64_t hit_count{};
   uint64_t bytes_processed{};
+  uint64_t page_faults{};
   std::string_view label{};
 };
 
+// Anchors live in a fixed table so blocks timed on worker threads never race
+// with a resize; counters are bumped through atomic_ref for the same reason.
 struct Profiler {
-  std::vector<ProfileAnchor> anchors{};
+  std::array<ProfileAnchor, 4096> anchors{};
   uint64_t start_tsc{};
   uint64_t end_tsc{};
+  uint64_t start_faults{};
   std::atomic<uint32_t> next_index{0};
 
-  auto get_next_index() -> uint32_t {
+  auto get_next_index(std::string_view label) -> uint32_t {
     auto idx = next_index++;
-    if (idx >= anchors.size()) {
-      anchors.resize(idx + 1);
-    }
+    anchors[idx].label = label;
     return idx;
   }
 };
@@ -62,25 +86,32 @@ inline Profiler global_profiler{};
 struct ProfileBlock {
   std::string_view label{};
   uint32_t anchor_idx{};
-  uint64_t start_tsc{};
   uint64_t bytes_processed{};
+  // Sampled outside the rdtsc pair so the getrusage calls are not timed.
+  uint64_t start_faults{};
+  uint64_t start_tsc{};
 
   ProfileBlock(std::string_view label, uint32_t anchor_idx,
                uint64_t bytes_processed = 0)
-      : label{label}, anchor_idx{anchor_idx}, start_tsc{rdtsc()},
-        bytes_processed{bytes_processed} {}
+      : label{label}, anchor_idx{anchor_idx},
+        bytes_processed{bytes_processed}, start_faults{page_faults()},
+        start_tsc{rdtsc()} {}
 
   ~ProfileBlock() {
     auto end_tsc = rdtsc();
+    auto faults = page_faults() - start_faults;
     auto &anchor = global_profiler.anchors[anchor_idx];
-    anchor.tsc_elapsed += (end_tsc - start_tsc);
-    anchor.hit_count++;
-    anchor.bytes_processed += bytes_processed;
-    anchor.label = label;
+    std::atomic_ref(anchor.tsc_elapsed)
+        .fetch_add(end_tsc - start_tsc, std::memory_order_relaxed);
+    std::atomic_ref(anchor.hit_count).fetch_add(1, std::memory_order_relaxed);
+    std::atomic_ref(anchor.bytes_processed)
+        .fetch_add(bytes_processed, std::memory_order_relaxed);
+    std::atomic_ref(anchor.page_faults)
+        .fetch_add(faults, std::memory_order_relaxed);
   }
 };
 
-inline auto print_time_elapsed(uint64_t total_tsc_elapsed,
+inline auto print_time_elapsed(uint64_t total_tsc_elapsed, uint64_t freq,
                                ProfileAnchor &anchor) -> void {
   auto percent =
       100.0 * (static_cast<double>(anchor.tsc_elapsed) / total_tsc_elapsed);
@@ -88,8 +119,7 @@ inline auto print_time_elapsed(uint64_t total_tsc_elapsed,
             << "]: " << anchor.tsc_elapsed << " (" << std::setprecision(2)
             << percent << "%)";
   if (anchor.bytes_processed > 0) {
-    auto seconds =
-        static_cast<double>(anchor.tsc_elapsed) / get_cpu_frequency();
+    auto seconds = static_cast<double>(anchor.tsc_elapsed) / freq;
     auto bandwidth =
         static_cast<double>(anchor.bytes_processed) / (seconds * 1024 * 1024);
     auto mb_processed =
@@ -97,10 +127,16 @@ inline auto print_time_elapsed(uint64_t total_tsc_elapsed,
     std::cout << " - " << std::setprecision(6) << bandwidth << " MB/s ("
               << std::setprecision(2) << mb_processed << " MB total)";
   }
+  if (anchor.page_faults > 0) {
+    std::cout << " - " << anchor.page_faults << " page faults";
+  }
   std::cout << std::endl;
 }
 
-inline auto begin_profile() -> void { global_profiler.start_tsc = rdtsc(); }
+inline auto begin_profile() -> void {
+  global_profiler.start_faults = page_faults(true);
+  global_profiler.start_tsc = rdtsc();
+}
 
 inline auto end_and_print_profile() -> void {
   global_profiler.end_tsc = rdtsc();
@@ -109,9 +145,11 @@ inline auto end_and_print_profile() -> void {
   std::cout << "Total time: "
             << static_cast<double>(1000 * total_tsc_elapsed) / freq
             << "ms (CPU freq: " << freq << ")\n";
+  std::cout << "Page faults: "
+            << page_faults(true) - global_profiler.start_faults << "\n";
   for (auto &anchor : global_profiler.anchors) {
     if (anchor.tsc_elapsed != 0) {
-      print_time_elapsed(total_tsc_elapsed, anchor);
+      print_time_elapsed(total_tsc_elapsed, freq, anchor);
     }
   }
 }
@@ -120,7 +158,7 @@ inline auto end_and_print_profile() -> void {
 #define NameConcat(A, B) NameConcat2(A, B)
 #define TimeBlock(Name, Bytes)                                                 \
   static const uint32_t NameConcat(BlockIndex, __LINE__) =                     \
-      global_profiler.get_next_index();                                        \
+      global_profiler.get_next_index(Name);                                    \
   ProfileBlock NameConcat(Block, __LINE__)(                                    \
       Name, NameConcat(BlockIndex, __LINE__), Bytes)
 #define TimeBandwidth(Bytes) TimeBlock(__func__, Bytes)
@@ -3,18 +3,40 @@
 #include <cctype>
 #include <filesystem>
 #include <fstream>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
-Scanner::Scanner(std::string &path) {
-  TimeBandwidth(std::filesystem::file_size(path));
-  std::ifstream file(path);
-  contents = std::vector(std::istreambuf_iterator<char>(file),
-                         std::istreambuf_iterator<char>());
+// Generated records average one token per ~5.8 bytes; assuming 5 leaves ~15%
+// headroom so the token vector never reallocates out of a caller's arena,
+// without prefaulting much memory it will not use.
+static constexpr uint64_t BYTES_PER_TOKEN = 5;
+
+Scanner::Scanner(std::string &path, std::pmr::memory_resource *resource)
+    : Scanner(resource) {
+  auto size = std::filesystem::file_size(path);
+  TimeBandwidth(size);
+  std::ifstream file(path, std::ios::binary);
+  contents.resize(size);
+  file.read(contents.data(), static_cast<std::streamsize>(size));
+  contents.resize(static_cast<size_t>(file.gcount()));
+}
+
+auto Scanner::from_source(std::string_view source,
+                          std::pmr::memory_resource *resource) -> Scanner {
+  Scanner s(resource);
+  s.contents.assign(source.begin(), source.end());
+  return s;
+}
+
+auto Scanner::reserve_bytes(uint64_t source_bytes) -> uint64_t {
+  return source_bytes + (source_bytes / BYTES_PER_TOKEN + 1) * sizeof(Token) +
+         4096;
 }
 
-auto Scanner::scan() -> std::vector<Token> & {
+auto Scanner::scan() -> std::pmr::vector<Token> & {
   TimeFunction;
+  tokens.reserve(contents.size() / BYTES_PER_TOKEN + 1);
   while (idx < contents.size()) {
     scan_token();
   }
@@ -37,7 +59,13 @@ auto Scanner::scan_token() -> void {
     tokens.emplace_back(Token::Comma);
   } else if (c == '"') {
     std::string s;
-    while ((c = advance()) != '"') {
+    while (true) {
+      if (idx >= contents.size()) {
+        throw std::runtime_error("Unterminated string");
+      }
+      if ((c = advance()) == '"') {
+        break;
+      }
       s.push_back(c);
     }
     tokens.emplace_back(Token::String, s);
@@ -49,8 +77,11 @@ auto Scanner::scan_token() -> void {
   } else if (std::isdigit(c) || c == '-') {
     std::string digits{c};
     bool is_float = false;
-    while (std::isdigit(peek()) || peek() == '.') {
-      is_float = peek() == '.' || is_float;
+    while (std::isdigit(peek()) || peek() == '.' || peek() == 'e' ||
+           peek() == 'E' ||
+           ((peek() == '-' || peek() == '+') &&
+            (digits.back() == 'e' || digits.back() == 'E'))) {
+      is_float = !std::isdigit(peek()) || is_float;
       digits.push_back(advance());
     }
     if (is_float) {
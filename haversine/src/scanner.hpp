@@ -1,7 +1,9 @@
 #pragma once
 
 #include <cstdint>
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <variant>
 #include <vector>
 #undef EOF
@@ -25,15 +27,28 @@ struct Token {
   std::variant<std::monostate, std::string, double, int32_t, bool> value{};
 };
 
+// Source bytes and tokens come from `resource`, so a caller can hand the
+// scanner an Arena sized with reserve_bytes().
 class Scanner {
-  std::vector<char> contents{};
-  std::vector<Token> tokens{};
+  std::pmr::vector<char> contents;
+  std::pmr::vector<Token> tokens;
   u_int32_t idx{};
   auto scan_token() -> void;
   auto advance() -> char { return contents[idx++]; }
-  auto peek() const -> char { return contents[idx]; }
+  auto peek() const -> char {
+    return idx < contents.size() ? contents[idx] : '\0';
+  }
+  explicit Scanner(std::pmr::memory_resource *resource)
+      : contents{resource}, tokens{resource} {}
 
 public:
-  Scanner(std::string &path);
-  auto scan() -> std::vector<Token> &;
+  Scanner(std::string &path, std::pmr::memory_resource *resource =
+                                 std::pmr::get_default_resource());
+  // Scans an in-memory buffer, e.g. a slice of a larger file.
+  static auto from_source(std::string_view source,
+                          std::pmr::memory_resource *resource =
+                              std::pmr::get_default_resource()) -> Scanner;
+  // Upper estimate of what scanning `source_bytes` of input allocates.
+  static auto reserve_bytes(uint64_t source_bytes) -> uint64_t;
+  auto scan() -> std::pmr::vector<Token> &;
 };
@@ -0,0 +1,308 @@
+#include "server.hpp"
+#include "haversine.hpp"
+#include "profile.hpp"
+#include "thread_pool.hpp"
+#include <cerrno>
+#include <charconv>
+#include <csignal>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+#include <system_error>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+Dataset::Dataset(const std::string &path)
+    : arena{std::make_unique<Arena>(
+          std::filesystem::file_size(path) / BYTES_PER_RECORD *
+              sizeof(PointPair),
+          ArenaOptions{HugePages::Transparent, true})},
+      pairs{load_point_pairs(path, arena.get())} {
+  for (auto &pair : pairs) {
+    total.sum += haversine(pair.x0, pair.y0, pair.x1, pair.y1, EARTH_RADIUS);
+  }
+  total.count = pairs.size();
+}
+
+auto Dataset::index() const -> const SpatialIndex & {
+  std::call_once(index_once, [this] {
+    spatial_index = SpatialIndex(to_geo_points(pairs));
+  });
+  return spatial_index;
+}
+
+auto DatasetCache::get(const std::string &path)
+    -> std::shared_ptr<const Dataset> {
+  std::error_code ec;
+  auto mtime = std::filesystem::last_write_time(path, ec);
+  auto size = ec ? 0 : std::filesystem::file_size(path, ec);
+  if (ec) {
+    throw std::runtime_error("Could not stat " + path + ": " + ec.message());
+  }
+
+  std::promise<std::shared_ptr<const Dataset>> promise;
+  Future dataset;
+  bool owner = false;
+  {
+    std::lock_guard lock(mutex);
+    auto it = by_path.find(path);
+    if (it != by_path.end() && it->second->mtime == mtime &&
+        it->second->size == size) {
+      entries.splice(entries.begin(), entries, it->second);
+      dataset = it->second->dataset;
+    } else {
+      if (it != by_path.end()) {
+        entries.erase(it->second);
+        by_path.erase(it);
+      }
+      dataset = promise.get_future().share();
+      entries.push_front({path, mtime, size, dataset});
+      by_path[path] = entries.begin();
+      while (entries.size() > capacity) {
+        by_path.erase(entries.back().path);
+        entries.pop_back();
+      }
+      owner = true;
+    }
+  }
+
+  // Load outside the lock; other requests for this path wait on the future.
+  // A failed load is reported to every waiter but not left in the cache.
+  if (owner) {
+    try {
+      promise.set_value(std::make_shared<const Dataset>(path));
+    } catch (...) {
+      promise.set_exception(std::current_exception());
+      std::lock_guard lock(mutex);
+      auto it = by_path.find(path);
+      if (it != by_path.end() && it->second->mtime == mtime &&
+          it->second->size == size) {
+        entries.erase(it->second);
+        by_path.erase(it);
+      }
+    }
+  }
+  return dataset.get();
+}
+
+auto DatasetCache::size() -> size_t {
+  std::lock_guard lock(mutex);
+  return entries.size();
+}
+
+static auto split(std::string_view line) -> std::vector<std::string_view> {
+  std::vector<std::string_view> words;
+  size_t i = 0;
+  while (i < line.size()) {
+    auto start = line.find_first_not_of(" \t\r", i);
+    if (start == std::string_view::npos) {
+      break;
+    }
+    auto end = line.find_first_of(" \t\r", start);
+    if (end == std::string_view::npos) {
+      end = line.size();
+    }
+    words.push_back(line.substr(start, end - start));
+    i = end;
+  }
+  return words;
+}
+
+static auto to_number(std::string_view word) -> double {
+  double value{};
+  auto [end, ec] = std::from_chars(word.data(), word.data() + word.size(),
+                                   value);
+  if (ec != std::errc{} || end != word.data() + word.size()) {
+    throw std::runtime_error("Invalid number: " + std::string(word));
+  }
+  return value;
+}
+
+static auto to_count(std::string_view word) -> uint32_t {
+  uint32_t value{};
+  auto [end, ec] = std::from_chars(word.data(), word.data() + word.size(),
+                                   value);
+  if (ec != std::errc{} || end != word.data() + word.size()) {
+    throw std::runtime_error("Invalid count: " + std::string(word));
+  }
+  return value;
+}
+
+static auto format_neighbours(const std::vector<SpatialIndex::Neighbour> &hits)
+    -> std::string {
+  auto out = std::format("OK {}", hits.size());
+  for (auto &hit : hits) {
+    out += std::format(" {}:{}", hit.id, hit.distance);
+  }
+  return out;
+}
+
+auto handle_request(DatasetCache &cache, std::string_view request)
+    -> std::string {
+  TimeFunction;
+  try {
+    auto words = split(request);
+    if (words.empty()) {
+      throw std::runtime_error("Empty request");
+    }
+    auto command = words[0];
+
+    if (command == "SUM" && words.size() == 2) {
+      auto dataset = cache.get(std::string(words[1]));
+      auto &total = dataset->total;
+      return std::format("OK {} {} {}", total.count, total.sum,
+                         total.count ? total.sum / total.count : 0.0);
+    }
+    if (command == "RADIUS" && words.size() == 5) {
+      auto dataset = cache.get(std::string(words[1]));
+      GeoPoint center{to_number(words[2]), to_number(words[3])};
+      return format_neighbours(
+          dataset->index().radius_query(center, to_number(words[4])));
+    }
+    if (command == "KNN" && words.size() == 5) {
+      auto dataset = cache.get(std::string(words[1]));
+      GeoPoint center{to_number(words[2]), to_number(words[3])};
+      return format_neighbours(
+          dataset->index().knn_query(center, to_count(words[4])));
+    }
+    if (command == "PAIRS" && words.size() > 1 && (words.size() - 1) % 4 == 0) {
+      std::string out = "OK";
+      for (size_t i = 1; i < words.size(); i += 4) {
+        out += std::format(
+            " {}", haversine(to_number(words[i]), to_number(words[i + 1]),
+                             to_number(words[i + 2]), to_number(words[i + 3]),
+                             EARTH_RADIUS));
+      }
+      return out;
+    }
+    throw std::runtime_error("Unknown request: " + std::string(command));
+  } catch (const std::exception &e) {
+    return std::format("ERR {}", e.what());
+  }
+}
+
+static auto write_all(int fd, std::string_view data) -> bool {
+  while (!data.empty()) {
+    auto n = ::write(fd, data.data(), data.size());
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    data.remove_prefix(static_cast<size_t>(n));
+  }
+  return true;
+}
+
+// Runs on the connection's own thread. Every complete request line becomes a
+// pool task; responses are written back in request order.
+static auto serve_client(DatasetCache &cache, ThreadPool &pool, int fd)
+    -> void {
+  std::string pending;
+  char buf[64 * 1024];
+  while (true) {
+    auto n = ::read(fd, buf, sizeof(buf));
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      break;
+    }
+    pending.append(buf, static_cast<size_t>(n));
+
+    size_t start = 0;
+    size_t newline;
+    std::vector<std::future<std::string>> results;
+    while ((newline = pending.find('\n', start)) != std::string::npos) {
+      auto promise = std::make_shared<std::promise<std::string>>();
+      results.push_back(promise->get_future());
+      pool.submit([&cache, promise,
+                   line = pending.substr(start, newline - start)] {
+        try {
+          promise->set_value(handle_request(cache, line));
+        } catch (...) {
+          promise->set_exception(std::current_exception());
+        }
+      });
+      start = newline + 1;
+    }
+    pending.erase(0, start);
+
+    std::string responses;
+    for (auto &result : results) {
+      try {
+        responses += result.get();
+      } catch (const std::exception &e) {
+        responses += std::format("ERR {}", e.what());
+      }
+      responses += '\n';
+    }
+    if (!write_all(fd, responses)) {
+      break;
+    }
+  }
+  ::close(fd);
+}
+
+auto run_server(const ServerOptions &options) -> void {
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  if (options.socket_path.size() >= sizeof(addr.sun_path)) {
+    throw std::runtime_error("Socket path too long: " + options.socket_path);
+  }
+  std::memcpy(addr.sun_path, options.socket_path.c_str(),
+              options.socket_path.size() + 1);
+
+  int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listener < 0) {
+    throw std::runtime_error(std::string("socket: ") + std::strerror(errno));
+  }
+  // Clear a stale socket from an earlier run, but never anything else that
+  // happens to live at the path.
+  struct stat existing {};
+  if (::lstat(options.socket_path.c_str(), &existing) == 0) {
+    if (!S_ISSOCK(existing.st_mode)) {
+      ::close(listener);
+      throw std::runtime_error("Not a socket: " + options.socket_path);
+    }
+    ::unlink(options.socket_path.c_str());
+  }
+  if (::bind(listener, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0 ||
+      ::listen(listener, SOMAXCONN) < 0) {
+    auto message = std::string("bind: ") + std::strerror(errno);
+    ::close(listener);
+    throw std::runtime_error(message);
+  }
+  // Clients that hang up mid-response must not kill the daemon.
+  std::signal(SIGPIPE, SIG_IGN);
+
+  // Connection threads are detached, so they share ownership of the cache
+  // and pool in case accept() fails and this frame unwinds under them.
+  struct Shared {
+    DatasetCache cache;
+    ThreadPool pool;
+    explicit Shared(const ServerOptions &options)
+        : cache{options.cache_capacity}, pool{options.num_threads} {}
+  };
+  auto shared = std::make_shared<Shared>(options);
+  while (true) {
+    int client = ::accept(listener, nullptr, nullptr);
+    if (client < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) {
+        continue;
+      }
+      throw std::runtime_error(std::string("accept: ") + std::strerror(errno));
+    }
+    // An idle connection only parks its own reader, never a pool worker.
+    try {
+      std::thread([shared, client] {
+        serve_client(shared->cache, shared->pool, client);
+      }).detach();
+    } catch (const std::system_error &) {
+      ::close(client);
+    }
+  }
+}
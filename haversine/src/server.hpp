@@ -0,0 +1,75 @@
+#pragma once
+
+#include "arena.hpp"
+#include "compute.hpp"
+#include "spatial_index.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// A parsed point file kept resident between requests. Coordinates live in an
+// arena sized from the file, and the spatial index over both endpoints of
+// every pair is built on the first query that needs it.
+class Dataset {
+  mutable std::once_flag index_once{};
+  mutable SpatialIndex spatial_index{};
+  std::unique_ptr<Arena> arena;
+
+public:
+  std::pmr::vector<PointPair> pairs;
+  RecordSum total{};
+
+  explicit Dataset(const std::string &path);
+  auto index() const -> const SpatialIndex &;
+};
+
+// LRU of datasets keyed by path. Entries are invalidated when the file's size
+// or modification time changes. Concurrent misses on the same path share one
+// load.
+class DatasetCache {
+  using Future = std::shared_future<std::shared_ptr<const Dataset>>;
+  struct Entry {
+    std::string path{};
+    std::filesystem::file_time_type mtime{};
+    uint64_t size{};
+    Future dataset{};
+  };
+
+  std::mutex mutex{};
+  std::list<Entry> entries{};
+  std::unordered_map<std::string, std::list<Entry>::iterator> by_path{};
+  size_t capacity{};
+
+public:
+  explicit DatasetCache(size_t capacity = 8) : capacity{capacity} {}
+  auto get(const std::string &path) -> std::shared_ptr<const Dataset>;
+  auto size() -> size_t;
+};
+
+struct ServerOptions {
+  std::string socket_path{};
+  uint32_t num_threads{std::thread::hardware_concurrency()};
+  size_t cache_capacity{8};
+};
+
+// Line protocol, one response line per request line:
+//   SUM <path>                          -> OK <count> <sum> <average>
+//   RADIUS <path> <lon> <lat> <km>      -> OK <n> <id>:<km>...
+//   KNN <path> <lon> <lat> <k>          -> OK <n> <id>:<km>...
+//   PAIRS <x0> <y0> <x1> <y1> [...]     -> OK <km>...
+// Point ids index both endpoints of every pair (pair i -> 2i, 2i + 1).
+// Failures answer `ERR <message>`.
+auto handle_request(DatasetCache &cache, std::string_view request)
+    -> std::string;
+// Serves the protocol on a Unix domain socket; does not return. Each
+// connection gets its own reader thread and each request line runs on a pool
+// of `num_threads` workers.
+auto run_server(const ServerOptions &options) -> void;
@@ -0,0 +1,284 @@
+#include "spatial_index.hpp"
+#include "profile.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <numbers>
+#include <stdexcept>
+
+static constexpr char INDEX_MAGIC[4] = {'H', 'V', 'I', 'X'};
+static constexpr uint32_t INDEX_VERSION = 1;
+
+static auto to_unit_vector(GeoPoint p, double (&v)[3]) -> void {
+  auto lon = 0.01745329251994329577 * p.x;
+  auto lat = 0.01745329251994329577 * p.y;
+  v[0] = std::cos(lat) * std::cos(lon);
+  v[1] = std::cos(lat) * std::sin(lon);
+  v[2] = std::sin(lat);
+}
+
+static auto coord(const SpatialIndex::Node &n, uint32_t axis) -> double {
+  return axis == 0 ? n.px : axis == 1 ? n.py : n.pz;
+}
+
+static auto chord2(const double (&q)[3], const SpatialIndex::Node &n)
+    -> double {
+  auto dx = q[0] - n.px;
+  auto dy = q[1] - n.py;
+  auto dz = q[2] - n.pz;
+  return dx * dx + dy * dy + dz * dz;
+}
+
+// Squared chord length subtending a great-circle distance on a sphere of the
+// given radius. Padded slightly so rounding never prunes a boundary point;
+// the exact haversine makes the final call.
+static auto max_chord2_for(double distance, double radius) -> double {
+  auto angle = std::min(distance / radius, std::numbers::pi);
+  auto chord = 2.0 * std::sin(angle / 2.0);
+  return chord * chord * (1.0 + 1e-9) + 1e-12;
+}
+
+static auto by_distance(const SpatialIndex::Neighbour &a,
+                        const SpatialIndex::Neighbour &b) -> bool {
+  return a.distance < b.distance;
+}
+
+SpatialIndex::SpatialIndex(std::span<const GeoPoint> points, double radius)
+    : radius{radius} {
+  TimeBandwidth(points.size() * sizeof(GeoPoint));
+  nodes.resize(points.size());
+  for (uint32_t i = 0; i < points.size(); i++) {
+    double v[3];
+    to_unit_vector(points[i], v);
+    nodes[i] = {v[0], v[1], v[2], points[i], i, 0};
+  }
+  build(0, static_cast<uint32_t>(nodes.size()));
+}
+
+// Implicit balanced tree: the median of [lo, hi) sits at the midpoint and
+// splits on the axis of greatest spread, so no child pointers are stored and
+// the node array can be written to disk as-is.
+auto SpatialIndex::build(uint32_t lo, uint32_t hi) -> void {
+  if (hi - lo <= 1) {
+    return;
+  }
+
+  double min[3] = {2, 2, 2};
+  double max[3] = {-2, -2, -2};
+  for (auto i = lo; i < hi; i++) {
+    for (uint32_t a = 0; a < 3; a++) {
+      min[a] = std::min(min[a], coord(nodes[i], a));
+      max[a] = std::max(max[a], coord(nodes[i], a));
+    }
+  }
+  uint32_t axis = 0;
+  for (uint32_t a = 1; a < 3; a++) {
+    if (max[a] - min[a] > max[axis] - min[axis]) {
+      axis = a;
+    }
+  }
+
+  auto mid = lo + (hi - lo) / 2;
+  std::nth_element(nodes.begin() + lo, nodes.begin() + mid,
+                   nodes.begin() + hi, [axis](const Node &a, const Node &b) {
+                     return coord(a, axis) < coord(b, axis);
+                   });
+  nodes[mid].axis = axis;
+  build(lo, mid);
+  build(mid + 1, hi);
+}
+
+auto SpatialIndex::radius_search(uint32_t lo, uint32_t hi,
+                                 const double (&q)[3], double max_chord2,
+                                 GeoPoint center, double distance,
+                                 std::vector<Neighbour> &out) const -> void {
+  while (lo < hi) {
+    auto mid = lo + (hi - lo) / 2;
+    const auto &node = nodes[mid];
+
+    if (chord2(q, node) <= max_chord2) {
+      auto d = haversine(center.x, center.y, node.point.x, node.point.y,
+                         radius);
+      if (d <= distance) {
+        out.push_back({node.id, d});
+      }
+    }
+
+    auto diff = q[node.axis] - coord(node, node.axis);
+    auto near_lo = diff < 0 ? lo : mid + 1;
+    auto near_hi = diff < 0 ? mid : hi;
+    if (diff * diff <= max_chord2) {
+      radius_search(near_lo, near_hi, q, max_chord2, center, distance,
+                    out);
+      lo = diff < 0 ? mid + 1 : lo;
+      hi = diff < 0 ? hi : mid;
+    } else {
+      lo = near_lo;
+      hi = near_hi;
+    }
+  }
+}
+
+// Candidates are ranked by squared chord (stored in `distance`) while
+// searching; callers convert the survivors to haversine distances.
+auto SpatialIndex::knn_search(uint32_t lo, uint32_t hi, const double (&q)[3],
+                              uint32_t k, std::vector<Neighbour> &heap) const
+    -> void {
+  if (lo >= hi) {
+    return;
+  }
+  auto mid = lo + (hi - lo) / 2;
+  const auto &node = nodes[mid];
+
+  auto d2 = chord2(q, node);
+  if (heap.size() < k) {
+    heap.push_back({mid, d2});
+    std::push_heap(heap.begin(), heap.end(), by_distance);
+  } else if (d2 < heap.front().distance) {
+    std::pop_heap(heap.begin(), heap.end(), by_distance);
+    heap.back() = {mid, d2};
+    std::push_heap(heap.begin(), heap.end(), by_distance);
+  }
+
+  auto diff = q[node.axis] - coord(node, node.axis);
+  if (diff < 0) {
+    knn_search(lo, mid, q, k, heap);
+  } else {
+    knn_search(mid + 1, hi, q, k, heap);
+  }
+  if (heap.size() < k || diff * diff < heap.front().distance) {
+    if (diff < 0) {
+      knn_search(mid + 1, hi, q, k, heap);
+    } else {
+      knn_search(lo, mid, q, k, heap);
+    }
+  }
+}
+
+auto SpatialIndex::radius_query(GeoPoint center, double distance) const
+    -> std::vector<Neighbour> {
+  double q[3];
+  to_unit_vector(center, q);
+
+  std::vector<Neighbour> out;
+  radius_search(0, static_cast<uint32_t>(nodes.size()), q,
+                max_chord2_for(distance, radius), center, distance, out);
+  std::sort(out.begin(), out.end(), by_distance);
+  return out;
+}
+
+auto SpatialIndex::knn_query(GeoPoint center, uint32_t k) const
+    -> std::vector<Neighbour> {
+  double q[3];
+  to_unit_vector(center, q);
+
+  std::vector<Neighbour> heap;
+  if (k == 0) {
+    return heap;
+  }
+  heap.reserve(std::min<size_t>(k, nodes.size()));
+  knn_search(0, static_cast<uint32_t>(nodes.size()), q, k, heap);
+
+  for (auto &n : heap) {
+    const auto &node = nodes[n.id];
+    n = {node.id, haversine(center.x, center.y, node.point.x, node.point.y,
+                            radius)};
+  }
+  std::sort(heap.begin(), heap.end(), by_distance);
+  return heap;
+}
+
+auto SpatialIndex::radius_query(std::span<const GeoPoint> centers,
+                                double distance) const
+    -> std::vector<std::vector<Neighbour>> {
+  TimeFunction;
+  std::vector<std::vector<Neighbour>> results;
+  results.reserve(centers.size());
+  for (auto center : centers) {
+    results.push_back(radius_query(center, distance));
+  }
+  return results;
+}
+
+auto SpatialIndex::knn_query(std::span<const GeoPoint> centers,
+                             uint32_t k) const
+    -> std::vector<std::vector<Neighbour>> {
+  TimeFunction;
+  std::vector<std::vector<Neighbour>> results;
+  results.reserve(centers.size());
+  for (auto center : centers) {
+    results.push_back(knn_query(center, k));
+  }
+  return results;
+}
+
+auto SpatialIndex::save(const std::string &path) const -> void {
+  TimeBandwidth(nodes.size() * sizeof(Node));
+  std::ofstream f(path, std::ios::binary);
+  if (!f) {
+    throw std::runtime_error("Could not open index for writing: " + path);
+  }
+  uint64_t count = nodes.size();
+  f.write(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+  f.write(reinterpret_cast<const char *>(&INDEX_VERSION),
+          sizeof(INDEX_VERSION));
+  f.write(reinterpret_cast<const char *>(&count), sizeof(count));
+  f.write(reinterpret_cast<const char *>(&radius), sizeof(radius));
+  f.write(reinterpret_cast<const char *>(nodes.data()),
+          static_cast<std::streamsize>(count * sizeof(Node)));
+  if (!f) {
+    throw std::runtime_error("Failed writing index: " + path);
+  }
+}
+
+auto SpatialIndex::load(const std::string &path) -> SpatialIndex {
+  TimeFunction;
+  std::ifstream f(path, std::ios::binary);
+  if (!f) {
+    throw std::runtime_error("Could not open index: " + path);
+  }
+
+  char magic[4];
+  uint32_t version{};
+  uint64_t count{};
+  SpatialIndex index;
+  f.read(magic, sizeof(magic));
+  f.read(reinterpret_cast<char *>(&version), sizeof(version));
+  f.read(reinterpret_cast<char *>(&count), sizeof(count));
+  f.read(reinterpret_cast<char *>(&index.radius), sizeof(index.radius));
+  if (!f || std::memcmp(magic, INDEX_MAGIC, sizeof(magic)) != 0 ||
+      version != INDEX_VERSION) {
+    throw std::runtime_error("Not a spatial index: " + path);
+  }
+
+  // The header is untrusted: size the node array from what the file holds.
+  auto remaining = std::filesystem::file_size(path) -
+                   static_cast<uint64_t>(f.tellg());
+  if (count > remaining / sizeof(Node) || count > UINT32_MAX) {
+    throw std::runtime_error("Truncated spatial index: " + path);
+  }
+  index.nodes.resize(count);
+  f.read(reinterpret_cast<char *>(index.nodes.data()),
+         static_cast<std::streamsize>(count * sizeof(Node)));
+  if (!f) {
+    throw std::runtime_error("Truncated spatial index: " + path);
+  }
+  for (auto &node : index.nodes) {
+    if (node.axis > 2 || node.id >= count) {
+      throw std::runtime_error("Corrupt spatial index: " + path);
+    }
+  }
+  return index;
+}
+
+auto to_geo_points(std::span<const PointPair> pairs) -> std::vector<GeoPoint> {
+  std::vector<GeoPoint> out;
+  out.reserve(pairs.size() * 2);
+  for (auto &pair : pairs) {
+    out.push_back({pair.x0, pair.y0});
+    out.push_back({pair.x1, pair.y1});
+  }
+  return out;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "compute.hpp"
+#include "haversine.hpp"
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+// Longitude (x) / latitude (y) in degrees, matching the generator's layout.
+struct GeoPoint {
+  double x{};
+  double y{};
+};
+
+// Static 3D k-d tree over points projected onto the unit sphere. Queries are
+// pruned on squared chord length, which is monotonic in great-circle
+// distance, so the exact haversine is only evaluated for survivors.
+class SpatialIndex {
+public:
+  struct Node {
+    double px{};
+    double py{};
+    double pz{};
+    GeoPoint point{};
+    uint32_t id{};
+    uint32_t axis{};
+  };
+
+  struct Neighbour {
+    uint32_t id{};
+    double distance{};
+  };
+
+  SpatialIndex() = default;
+  explicit SpatialIndex(std::span<const GeoPoint> points,
+                        double radius = EARTH_RADIUS);
+
+  auto size() const -> size_t { return nodes.size(); }
+  auto radius_query(GeoPoint center, double distance) const
+      -> std::vector<Neighbour>;
+  auto knn_query(GeoPoint center, uint32_t k) const -> std::vector<Neighbour>;
+  auto radius_query(std::span<const GeoPoint> centers, double distance) const
+      -> std::vector<std::vector<Neighbour>>;
+  auto knn_query(std::span<const GeoPoint> centers, uint32_t k) const
+      -> std::vector<std::vector<Neighbour>>;
+
+  auto save(const std::string &path) const -> void;
+  static auto load(const std::string &path) -> SpatialIndex;
+
+private:
+  std::vector<Node> nodes{};
+  double radius{EARTH_RADIUS};
+
+  auto build(uint32_t lo, uint32_t hi) -> void;
+  auto radius_search(uint32_t lo, uint32_t hi, const double (&q)[3],
+                     double max_chord2, GeoPoint center, double distance,
+                     std::vector<Neighbour> &out) const -> void;
+  auto knn_search(uint32_t lo, uint32_t hi, const double (&q)[3], uint32_t k,
+                  std::vector<Neighbour> &heap) const -> void;
+};
+
+// Both endpoints of every pair, in record order: pair i yields points 2i and
+// 2i + 1.
+auto to_geo_points(std::span<const PointPair> pairs) -> std::vector<GeoPoint>;
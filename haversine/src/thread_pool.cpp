@@ -0,0 +1,117 @@
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <utility>
+
+static thread_local ThreadPool *current_pool{};
+static thread_local uint32_t current_worker{};
+
+ThreadPool::ThreadPool(uint32_t num_threads) {
+  num_threads = std::max(num_threads, 1u);
+  for (uint32_t i = 0; i < num_threads; i++) {
+    queues.push_back(std::make_unique<Queue>());
+  }
+  for (uint32_t i = 0; i < num_threads; i++) {
+    threads.emplace_back([this, i] { run(i); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard lock(mutex);
+    stopping = true;
+  }
+  work_cv.notify_all();
+  for (auto &t : threads) {
+    t.join();
+  }
+}
+
+auto ThreadPool::submit(std::function<void()> task) -> void {
+  // Count the task before it becomes visible, so a thief that finishes it
+  // first cannot drive the counters below zero or let wait() return early.
+  {
+    std::lock_guard lock(mutex);
+    queued++;
+    unfinished++;
+  }
+  auto &queue = current_pool == this ? *queues[current_worker] : injected;
+  {
+    std::lock_guard lock(queue.mutex);
+    queue.tasks.push_back(std::move(task));
+  }
+  work_cv.notify_one();
+}
+
+auto ThreadPool::wait() -> void {
+  std::unique_lock lock(mutex);
+  done_cv.wait(lock, [this] { return unfinished == 0; });
+  if (error) {
+    std::rethrow_exception(std::exchange(error, nullptr));
+  }
+}
+
+auto ThreadPool::try_pop(uint32_t id, std::function<void()> &task) -> bool {
+  {
+    auto &own = *queues[id];
+    std::lock_guard lock(own.mutex);
+    if (!own.tasks.empty()) {
+      task = std::move(own.tasks.back());
+      own.tasks.pop_back();
+      return true;
+    }
+  }
+  {
+    std::lock_guard lock(injected.mutex);
+    if (!injected.tasks.empty()) {
+      task = std::move(injected.tasks.front());
+      injected.tasks.pop_front();
+      return true;
+    }
+  }
+  for (uint32_t i = 1; i < queues.size(); i++) {
+    auto &victim = *queues[(id + i) % queues.size()];
+    std::lock_guard lock(victim.mutex);
+    if (!victim.tasks.empty()) {
+      task = std::move(victim.tasks.front());
+      victim.tasks.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
+
+auto ThreadPool::run(uint32_t id) -> void {
+  current_pool = this;
+  current_worker = id;
+
+  std::function<void()> task;
+  while (true) {
+    if (try_pop(id, task)) {
+      {
+        std::lock_guard lock(mutex);
+        queued--;
+      }
+      try {
+        task();
+      } catch (...) {
+        std::lock_guard lock(mutex);
+        if (!error) {
+          error = std::current_exception();
+        }
+      }
+      task = nullptr;
+
+      std::lock_guard lock(mutex);
+      if (--unfinished == 0) {
+        done_cv.notify_all();
+      }
+      continue;
+    }
+
+    std::unique_lock lock(mutex);
+    work_cv.wait(lock, [this] { return queued > 0 || stopping; });
+    if (stopping && queued == 0) {
+      return;
+    }
+  }
+}
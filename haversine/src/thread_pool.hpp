@@ -0,0 +1,53 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing pool: every worker owns a deque, pops its own newest task and
+// steals the oldest task from a sibling when it runs dry. Tasks submitted from
+// a worker land on that worker's deque, so recursive splits stay local until
+// another core goes idle. Tasks submitted from outside the pool go to a shared
+// queue that workers drain oldest first, so they start in submission order.
+class ThreadPool {
+  struct Queue {
+    std::mutex mutex{};
+    std::deque<std::function<void()>> tasks{};
+  };
+
+  std::vector<std::unique_ptr<Queue>> queues{};
+  Queue injected{};
+  std::vector<std::thread> threads{};
+  std::mutex mutex{};
+  std::condition_variable work_cv{};
+  std::condition_variable done_cv{};
+  uint64_t queued{};
+  uint64_t unfinished{};
+  bool stopping{};
+  std::exception_ptr error{};
+
+  auto run(uint32_t id) -> void;
+  auto try_pop(uint32_t id, std::function<void()> &task) -> bool;
+
+public:
+  explicit ThreadPool(
+      uint32_t num_threads = std::thread::hardware_concurrency());
+  ~ThreadPool();
+  ThreadPool(const ThreadPool &) = delete;
+  auto operator=(const ThreadPool &) -> ThreadPool & = delete;
+
+  auto size() const -> uint32_t {
+    return static_cast<uint32_t>(threads.size());
+  }
+  auto submit(std::function<void()> task) -> void;
+  // Blocks until every submitted task, including ones spawned by tasks, has
+  // finished, then rethrows the first exception a task threw. Must not be
+  // called from a worker.
+  auto wait() -> void;
+};
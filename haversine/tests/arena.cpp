@@ -0,0 +1,76 @@
+#include "../src/arena.hpp"
+#include "../src/scanner.hpp"
+#include <cstdint>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <numeric>
+#include <string>
+#include <vector>
+
+TEST(ArenaTest, BumpAllocatesAligned) {
+  Arena arena(1024, {HugePages::None});
+  auto a = arena.allocate(3, 1);
+  auto b = arena.allocate(16, 64);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(b) % 64, 0);
+  EXPECT_GT(b, a);
+  EXPECT_EQ(arena.bytes_used(), 64 + 16);
+  EXPECT_EQ(arena.size() % Arena::HUGE_PAGE_BYTES, 0);
+}
+
+TEST(ArenaTest, NewestBlockCanBeFreed) {
+  Arena arena(1024, {HugePages::None});
+  auto a = arena.allocate(100, 8);
+  arena.deallocate(a, 100, 8);
+  EXPECT_EQ(arena.bytes_used(), 0);
+  EXPECT_EQ(arena.allocate(100, 8), a);
+}
+
+TEST(ArenaTest, SpillsPastCapacity) {
+  Arena arena(1, {HugePages::None});
+  std::pmr::vector<char> v(&arena);
+  v.resize(Arena::HUGE_PAGE_BYTES * 3, 'x');
+  EXPECT_EQ(v.back(), 'x');
+  EXPECT_LE(arena.bytes_used(), arena.size());
+}
+
+TEST(ArenaTest, ResetReusesMemory) {
+  Arena arena(4096, {HugePages::None});
+  auto a = arena.allocate(128, 8);
+  auto b = arena.allocate(128, 8);
+  EXPECT_NE(a, b);
+  arena.reset();
+  EXPECT_EQ(arena.bytes_used(), 0);
+  EXPECT_EQ(arena.allocate(128, 8), a);
+}
+
+TEST(ArenaTest, ExplicitHugePagesFallBack) {
+  // Whatever the host's hugetlb pool looks like, the arena must be usable.
+  Arena arena(Arena::HUGE_PAGE_BYTES, {HugePages::Explicit});
+  auto p = static_cast<char *>(arena.allocate(4096, 8));
+  p[0] = 'a';
+  p[4095] = 'b';
+  EXPECT_EQ(p[0], 'a');
+  EXPECT_EQ(p[4095], 'b');
+}
+
+TEST(ArenaTest, PrefaultPreservesWrites) {
+  Arena arena(64 * 1024 * 1024, {HugePages::Transparent, true});
+  std::pmr::vector<uint32_t> v(&arena);
+  v.resize(8 * 1024 * 1024);
+  std::iota(v.begin(), v.end(), 0u);
+  EXPECT_EQ(v[12345], 12345u);
+  EXPECT_EQ(v.back(), v.size() - 1);
+}
+
+TEST(ArenaTest, ScannerUsesArena) {
+  std::string test_filename = "arena_test.json";
+  std::ofstream(test_filename) << R"({"points": [{"x0": 1.5}]})";
+
+  Arena arena(Scanner::reserve_bytes(64), {HugePages::None});
+  Scanner scanner(test_filename, &arena);
+  auto &tokens = scanner.scan();
+  EXPECT_EQ(tokens.size(), 11);
+  EXPECT_EQ(tokens.get_allocator().resource(), &arena);
+  EXPECT_GT(arena.bytes_used(), 0);
+  std::remove(test_filename.c_str());
+}
@@ -0,0 +1,118 @@
+#include "../src/batch.hpp"
+#include "../src/haversine.hpp"
+#include "../src/thread_pool.hpp"
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+class BatchTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    test_dir = "batch_test";
+    std::filesystem::create_directories(test_dir);
+  }
+
+  void TearDown() override { std::filesystem::remove_all(test_dir); }
+
+  // Writes `n` records in the generator's layout and returns their sum.
+  auto writePoints(const std::string &name, int n) -> double {
+    double sum{};
+    std::ofstream f(test_dir + "/" + name);
+    f << "{\"points\": [";
+    for (int i = 0; i < n; i++) {
+      double x0 = i % 360 - 180.0 + 0.25, y0 = i % 180 - 90.0 + 0.5;
+      double x1 = -x0 / 2, y1 = -y0 / 3;
+      sum += haversine(x0, y0, x1, y1, EARTH_RADIUS);
+      f << "{\"x0\": " << x0 << ", \"y0\": " << y0 << ", \"x1\": " << x1
+        << ", \"y1\": " << y1 << "}" << (i + 1 < n ? "," : "");
+    }
+    f << "]}";
+    return sum;
+  }
+
+  std::string test_dir;
+};
+
+TEST(ThreadPoolTest, RunsNestedTasks) {
+  std::atomic<int> count{};
+  ThreadPool pool(4);
+  for (int i = 0; i < 100; i++) {
+    pool.submit([&] {
+      count++;
+      pool.submit([&] { count++; });
+    });
+  }
+  pool.wait();
+  EXPECT_EQ(count, 200);
+}
+
+TEST(ThreadPoolTest, RethrowsTaskException) {
+  ThreadPool pool(2);
+  pool.submit([] { throw std::runtime_error("boom"); });
+  EXPECT_THROW(pool.wait(), std::runtime_error);
+  pool.submit([] {});
+  EXPECT_NO_THROW(pool.wait());
+}
+
+TEST(ThreadPoolTest, StartsExternalTasksInSubmitOrder) {
+  ThreadPool pool(1);
+  std::promise<void> release;
+  pool.submit([gate = release.get_future().share()] { gate.wait(); });
+
+  std::vector<int> order;
+  for (int i = 0; i < 8; i++) {
+    pool.submit([&order, i] { order.push_back(i); });
+  }
+  release.set_value();
+  pool.wait();
+  EXPECT_EQ(order, (std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7}));
+}
+
+TEST_F(BatchTest, CollectsJsonFilesFromDirectory) {
+  writePoints("b.json", 1);
+  writePoints("a.json", 1);
+  std::ofstream(test_dir + "/notes.txt") << "skip";
+
+  auto paths = collect_batch_paths({test_dir, "other.json"});
+  ASSERT_EQ(paths.size(), 3);
+  EXPECT_EQ(paths[0], test_dir + "/a.json");
+  EXPECT_EQ(paths[1], test_dir + "/b.json");
+  EXPECT_EQ(paths[2], "other.json");
+}
+
+TEST_F(BatchTest, SplitsLargeFilesAndGroupsSmallOnes) {
+  std::vector<double> expected;
+  std::vector<int> counts = {2000, 1, 0, 17, 300};
+  for (size_t i = 0; i < counts.size(); i++) {
+    expected.push_back(
+        writePoints("f" + std::to_string(i) + ".json", counts[i]));
+  }
+
+  // Small chunks force the 2000-point file across many chunk boundaries.
+  auto result = run_batch(collect_batch_paths({test_dir}), {4096, 4});
+  ASSERT_EQ(result.files.size(), counts.size());
+  uint64_t total{};
+  for (size_t i = 0; i < counts.size(); i++) {
+    auto &file = result.files[i];
+    EXPECT_TRUE(file.error.empty()) << file.error;
+    EXPECT_EQ(file.total.count, counts[i]);
+    EXPECT_NEAR(file.total.sum, expected[i], 1e-6 * (expected[i] + 1));
+    total += counts[i];
+  }
+  EXPECT_EQ(result.total.count, total);
+}
+
+TEST_F(BatchTest, ReportsPerFileErrors) {
+  writePoints("good.json", 10);
+  auto result =
+      run_batch({test_dir + "/good.json", test_dir + "/missing.json"}, {});
+  ASSERT_EQ(result.files.size(), 2);
+  EXPECT_TRUE(result.files[0].error.empty());
+  EXPECT_EQ(result.files[0].total.count, 10);
+  EXPECT_FALSE(result.files[1].error.empty());
+  EXPECT_EQ(result.total.count, 10);
+}
@@ -0,0 +1,151 @@
+#include "../src/haversine.hpp"
+#include "../src/incremental.hpp"
+#include <fstream>
+#include <gtest/gtest.h>
+#include <string>
+
+class IncrementalTest : public ::testing::Test {
+protected:
+  void SetUp() override { test_filename = "incremental_test.json"; }
+
+  void TearDown() override {
+    std::remove(test_filename.c_str());
+    std::remove(checkpoint_path(test_filename).c_str());
+  }
+
+  void writeToFile(const std::string &content) {
+    std::ofstream file(test_filename, std::ios::binary);
+    file << content;
+    file.close();
+  }
+
+  static auto record(int i) -> std::string {
+    return "{\"x0\": " + std::to_string(i) + ", \"y0\": 1, \"x1\": " +
+           std::to_string(-i) + ", \"y1\": -1}";
+  }
+
+  static auto distance(int i) -> double {
+    return haversine(i, 1, -i, -1, EARTH_RADIUS);
+  }
+
+  // `{"points": [...]}` holding records [0, n).
+  static auto document(int n) -> std::string {
+    std::string out = "{\"points\": [";
+    for (int i = 0; i < n; i++) {
+      out += (i ? ", " : "") + record(i);
+    }
+    return out + "]}";
+  }
+
+  std::string test_filename;
+};
+
+TEST_F(IncrementalTest, FirstRunIsFullPass) {
+  writeToFile(document(3));
+  auto result = sum_incremental(test_filename);
+  EXPECT_TRUE(result.full_rerun);
+  EXPECT_EQ(result.new_records, 3);
+  EXPECT_EQ(result.checkpoint.total.count, 3);
+  EXPECT_DOUBLE_EQ(result.checkpoint.total.sum,
+                   distance(0) + distance(1) + distance(2));
+
+  auto saved = load_checkpoint(test_filename);
+  ASSERT_TRUE(saved.has_value());
+  EXPECT_EQ(saved->offset, result.checkpoint.offset);
+  EXPECT_EQ(saved->total.sum, result.checkpoint.total.sum);
+}
+
+TEST_F(IncrementalTest, OnlyAppendedRecordsAreParsed) {
+  writeToFile(document(3));
+  sum_incremental(test_filename);
+
+  // Appending to the array rewrites the closing "]}".
+  writeToFile(document(5));
+  auto result = sum_incremental(test_filename);
+  EXPECT_FALSE(result.full_rerun);
+  EXPECT_EQ(result.new_records, 2);
+  EXPECT_EQ(result.checkpoint.total.count, 5);
+  EXPECT_DOUBLE_EQ(result.checkpoint.total.sum, distance(0) + distance(1) +
+                                                    distance(2) + distance(3) +
+                                                    distance(4));
+
+  auto again = sum_incremental(test_filename);
+  EXPECT_FALSE(again.full_rerun);
+  EXPECT_EQ(again.new_records, 0);
+  EXPECT_EQ(again.checkpoint.total.count, 5);
+}
+
+TEST_F(IncrementalTest, RewrittenFileFallsBackToFullPass) {
+  writeToFile(document(3));
+  sum_incremental(test_filename);
+
+  // Same length as an append would be, but an earlier record changed.
+  auto rewritten = document(4);
+  rewritten.replace(rewritten.find("\"x0\": 1,"), 9, "\"x0\": 7,");
+  writeToFile(rewritten);
+  auto result = sum_incremental(test_filename);
+  EXPECT_TRUE(result.full_rerun);
+  EXPECT_EQ(result.new_records, 4);
+  EXPECT_DOUBLE_EQ(result.checkpoint.total.sum,
+                   distance(0) + haversine(7, 1, -1, -1, EARTH_RADIUS) +
+                       distance(2) + distance(3));
+}
+
+TEST_F(IncrementalTest, TruncatedFileFallsBackToFullPass) {
+  writeToFile(document(5));
+  sum_incremental(test_filename);
+
+  writeToFile(document(2));
+  auto result = sum_incremental(test_filename);
+  EXPECT_TRUE(result.full_rerun);
+  EXPECT_EQ(result.checkpoint.total.count, 2);
+}
+
+TEST_F(IncrementalTest, DetectsEditsOnlyInsideHashWindows) {
+  auto original = document(400);
+  auto offset = original.rfind('}', original.size() - 2) + 1;
+  // Same-length edit of record i's y0, which is read back as `1`.
+  auto edited = [&](int i) {
+    auto doc = original;
+    auto at = doc.find(record(i)) + record(i).find("\"y0\": 1") + 6;
+    doc[at] = '2';
+    return std::pair{doc, static_cast<uint64_t>(at)};
+  };
+
+  for (auto [i, detected] : {std::pair{1, true}, std::pair{399, true},
+                             std::pair{200, false}}) {
+    writeToFile(original);
+    std::remove(checkpoint_path(test_filename).c_str());
+    sum_incremental(test_filename);
+
+    auto [doc, at] = edited(i);
+    if (!detected) {
+      ASSERT_GE(at, CHECKPOINT_HASH_WINDOW);
+      ASSERT_LT(at, offset - CHECKPOINT_HASH_WINDOW);
+    }
+    writeToFile(doc);
+    EXPECT_EQ(sum_incremental(test_filename).full_rerun, detected)
+        << "record " << i;
+  }
+}
+
+TEST_F(IncrementalTest, NdjsonWaitsForPartialRecord) {
+  writeToFile(record(0) + "\n" + record(1) + "\n{\"x0\": 2, ");
+  auto first = sum_incremental(test_filename);
+  EXPECT_EQ(first.checkpoint.total.count, 2);
+
+  writeToFile(record(0) + "\n" + record(1) + "\n" + record(2) + "\n");
+  auto second = sum_incremental(test_filename);
+  EXPECT_FALSE(second.full_rerun);
+  EXPECT_EQ(second.new_records, 1);
+  EXPECT_DOUBLE_EQ(second.checkpoint.total.sum,
+                   distance(0) + distance(1) + distance(2));
+}
+
+TEST_F(IncrementalTest, CorruptCheckpointIsIgnored) {
+  writeToFile(document(2));
+  std::ofstream(checkpoint_path(test_filename)) << "garbage";
+  auto result = sum_incremental(test_filename);
+  EXPECT_TRUE(result.full_rerun);
+  EXPECT_EQ(result.checkpoint.total.count, 2);
+}
@@ -0,0 +1,112 @@
+#include "../src/lazy.hpp"
+#include <fstream>
+#include <gtest/gtest.h>
+#include <string>
+
+class LazyTest : public ::testing::Test {
+protected:
+  void SetUp() override { test_filename = "lazy_test.json"; }
+
+  void TearDown() override { std::remove(test_filename.c_str()); }
+
+  std::string test_filename;
+};
+
+TEST_F(LazyTest, Scalars) {
+  auto doc = LazyDocument::from_source(R"({
+        "string": "hello",
+        "number": 42,
+        "float": -3.14e2,
+        "boolean": true,
+        "nothing": null
+    })");
+  auto root = doc.root();
+
+  EXPECT_EQ(root.type(), LazyValue::Type::Object);
+  EXPECT_EQ(root.size(), 5);
+  EXPECT_EQ(root["string"].get_string(), "hello");
+  EXPECT_EQ(root["number"].get_double(), 42.0);
+  EXPECT_EQ(root["float"].get_double(), -314.0);
+  EXPECT_TRUE(root["boolean"].get_bool());
+  EXPECT_TRUE(root["nothing"].is_null());
+  EXPECT_FALSE(root.find("missing").has_value());
+  EXPECT_THROW(root["missing"], std::runtime_error);
+  EXPECT_THROW(root["string"].get_double(), std::runtime_error);
+}
+
+TEST_F(LazyTest, SkipsNestedSubtrees) {
+  auto doc = LazyDocument::from_source(R"({
+        "skip": {"a": [1, [2, {"b": "}]"}], 3], "c": {}},
+        "empty": [],
+        "points": [{"x0": 1}, {"x0": 2}, {"x0": 3, "y0": [4, 5]}]
+    })");
+
+  auto points = doc.root()["points"];
+  EXPECT_EQ(points.size(), 3);
+  EXPECT_EQ(points.at(2)["x0"].get_double(), 3.0);
+  EXPECT_EQ(points.at(2)["y0"].at(1).get_double(), 5.0);
+  EXPECT_EQ(doc.root()["empty"].size(), 0);
+  EXPECT_EQ(doc.root()["skip"].size(), 2);
+  EXPECT_EQ(doc.root()["skip"]["a"].at(1).at(1)["b"].get_string(), "}]");
+  EXPECT_THROW(points.at(3), std::runtime_error);
+}
+
+TEST_F(LazyTest, JsonPointer) {
+  auto doc = LazyDocument::from_source(
+      R"({"points": [{"x0": 1.5}, {"x0": 2.5}], "a/b": {"m~n": 7}, "": 8})");
+
+  EXPECT_EQ(doc.at_pointer("").size(), 3);
+  EXPECT_EQ(doc.at_pointer("/points").size(), 2);
+  EXPECT_EQ(doc.at_pointer("/points/1/x0").get_double(), 2.5);
+  EXPECT_EQ(doc.at_pointer("/a~1b/m~0n").get_double(), 7.0);
+  EXPECT_EQ(doc.at_pointer("/").get_double(), 8.0);
+  EXPECT_THROW(doc.at_pointer("points"), std::runtime_error);
+  EXPECT_THROW(doc.at_pointer("/points/x"), std::runtime_error);
+  EXPECT_THROW(doc.at_pointer("/points/9"), std::runtime_error);
+}
+
+TEST_F(LazyTest, StringEscapes) {
+  auto doc = LazyDocument::from_source(
+      R"({"k\"ey": "a\"b\\c\/d\né😀"})");
+  EXPECT_EQ(doc.root()["k\"ey"].get_string(),
+            "a\"b\\c/d\n\xc3\xa9\xf0\x9f\x98\x80");
+}
+
+TEST_F(LazyTest, UnicodeEscapes) {
+  auto doc = LazyDocument::from_source(
+      R"({"a": "\u0041\u00e9\u20AC", "b": "\ud83d\ude00!", "c": "\u00"})");
+  EXPECT_EQ(doc.root()["a"].get_string(), "A\xc3\xa9\xe2\x82\xac");
+  EXPECT_EQ(doc.root()["b"].get_string(), "\xf0\x9f\x98\x80!");
+  EXPECT_THROW(doc.root()["c"].get_string(), std::runtime_error);
+
+  for (auto lone : {R"({"s": "\ud83d"})", R"({"s": "\ud83dx"})",
+                    R"({"s": "\ud83d\u0041"})", R"({"s": "\ude00"})"}) {
+    auto bad = LazyDocument::from_source(lone);
+    EXPECT_THROW(bad.root()["s"].get_string(), std::runtime_error) << lone;
+  }
+}
+
+TEST_F(LazyTest, InvalidNullLiteral) {
+  auto doc = LazyDocument::from_source(R"({"a": null, "b": nonsense})");
+  EXPECT_TRUE(doc.root()["a"].is_null());
+  EXPECT_FALSE(doc.root()["b"].is_null());
+}
+
+TEST_F(LazyTest, ReadsFile) {
+  {
+    std::ofstream f(test_filename);
+    f << R"({"points": [{"x0": 1, "y0": 2, "x1": 3, "y1": 4}]})";
+  }
+  LazyDocument doc(test_filename);
+  EXPECT_EQ(doc.at_pointer("/points/0/y1").get_double(), 4.0);
+}
+
+TEST_F(LazyTest, InvalidJson) {
+  EXPECT_THROW(LazyDocument::from_source("{"), std::runtime_error);
+  EXPECT_THROW(LazyDocument::from_source("[}"), std::runtime_error);
+  EXPECT_THROW(LazyDocument::from_source(R"({"key)"), std::runtime_error);
+  EXPECT_THROW(LazyDocument::from_source("{@}"), std::runtime_error);
+  EXPECT_THROW(LazyDocument::from_source(""), std::runtime_error);
+  EXPECT_THROW(LazyDocument::from_source(R"({42: "value"})").root()["x"],
+               std::runtime_error);
+}
@@ -0,0 +1,187 @@
+#include "../src/haversine.hpp"
+#include "../src/ndjson.hpp"
+#include <condition_variable>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+// Stands in for a pipe: reads block until a writer supplies bytes or closes,
+// and only what has been written so far is reported as available.
+class PipeBuf : public std::streambuf {
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::string pending;
+  std::string current;
+  bool closed{};
+
+protected:
+  auto underflow() -> int_type override {
+    std::unique_lock lock(mutex);
+    cv.wait(lock, [this] { return !pending.empty() || closed; });
+    if (pending.empty()) {
+      return traits_type::eof();
+    }
+    current = std::exchange(pending, {});
+    setg(current.data(), current.data(), current.data() + current.size());
+    return traits_type::to_int_type(current[0]);
+  }
+
+  auto showmanyc() -> std::streamsize override {
+    std::lock_guard lock(mutex);
+    return static_cast<std::streamsize>(pending.size());
+  }
+
+public:
+  void write(const std::string &bytes) {
+    std::lock_guard lock(mutex);
+    pending += bytes;
+    cv.notify_all();
+  }
+
+  void close() {
+    std::lock_guard lock(mutex);
+    closed = true;
+    cv.notify_all();
+  }
+};
+
+class NdjsonTest : public ::testing::Test {
+protected:
+  void SetUp() override { test_filename = "test.ndjson"; }
+
+  void TearDown() override { std::remove(test_filename.c_str()); }
+
+  // Appends `n` lines to `out` and returns their sum.
+  static auto writeLines(std::ostream &out, int n, int offset = 0) -> double {
+    double sum{};
+    out << std::setprecision(17);
+    for (int i = offset; i < offset + n; i++) {
+      double x0 = i % 360 - 180.0, y0 = i % 180 - 90.0 + 0.5;
+      double x1 = x0 / 3, y1 = -y0 / 2;
+      sum += haversine(x0, y0, x1, y1, EARTH_RADIUS);
+      out << "{\"x0\":" << x0 << ",\"y0\":" << y0 << ",\"x1\":" << x1
+          << ",\"y1\":" << y1 << "}\n";
+    }
+    return sum;
+  }
+
+  std::string test_filename;
+};
+
+TEST_F(NdjsonTest, EmptyInput) {
+  std::istringstream in("");
+  auto total = sum_ndjson(in);
+  EXPECT_EQ(total.count, 0);
+  EXPECT_EQ(total.sum, 0);
+}
+
+TEST_F(NdjsonTest, FinalLineWithoutNewline) {
+  std::istringstream in("{\"x0\": 0, \"y0\": 0, \"x1\": 1, \"y1\": 1}\n\n"
+                        "{\"x0\": 10, \"y0\": 20, \"x1\": -30, \"y1\": 40}");
+  auto total = sum_ndjson(in, {16, 2});
+  EXPECT_EQ(total.count, 2);
+  EXPECT_DOUBLE_EQ(total.sum, haversine(0, 0, 1, 1, EARTH_RADIUS) +
+                                  haversine(10, 20, -30, 40, EARTH_RADIUS));
+}
+
+TEST_F(NdjsonTest, SplitsBlocksAcrossThreads) {
+  std::stringstream in;
+  auto expected = writeLines(in, 20000);
+
+  uint64_t progress_calls{};
+  auto total = sum_ndjson(in, {256 * 1024, 4},
+                          [&](const RecordSum &) { progress_calls++; });
+  EXPECT_EQ(total.count, 20000);
+  EXPECT_NEAR(total.sum, expected, 1e-9 * expected);
+  EXPECT_GT(progress_calls, 1);
+}
+
+TEST_F(NdjsonTest, RejectsMalformedLine) {
+  std::istringstream in("{\"x0\": 0, \"y0\": }\n");
+  EXPECT_THROW(sum_ndjson(in), std::runtime_error);
+}
+
+TEST_F(NdjsonTest, RejectsLineCutAfterValue) {
+  std::istringstream in("{\"x0\": 1\n");
+  EXPECT_THROW(sum_ndjson(in, {16, 2}), std::runtime_error);
+}
+
+TEST_F(NdjsonTest, RejectsUnterminatedString) {
+  std::istringstream in("{\"x0\": \"abc\n");
+  EXPECT_THROW(sum_ndjson(in, {16, 2}), std::runtime_error);
+}
+
+TEST_F(NdjsonTest, FollowsAppendedLines) {
+  std::ofstream out(test_filename);
+  auto expected = writeLines(out, 10);
+  out.flush();
+
+  std::ifstream in(test_filename, std::ios::binary);
+  std::stop_source stop;
+  NdjsonOptions options{4096, 2, true, std::chrono::milliseconds(5)};
+  RecordSum total{};
+  std::thread reader([&] {
+    total = sum_ndjson(
+        in, options,
+        [&](const RecordSum &running) {
+          if (running.count == 25) {
+            stop.request_stop();
+          }
+        },
+        stop.get_token());
+  });
+
+  // A partial line must wait for its newline.
+  out << "{\"x0\": 1, ";
+  out.flush();
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  out << "\"y0\": 2, \"x1\": 3, \"y1\": 4}\n";
+  expected += haversine(1, 2, 3, 4, EARTH_RADIUS);
+  expected += writeLines(out, 14, 10);
+  out.flush();
+  reader.join();
+
+  EXPECT_EQ(total.count, 25);
+  EXPECT_NEAR(total.sum, expected, 1e-9 * expected);
+}
+
+TEST_F(NdjsonTest, ReportsPipedLinesBeforeBlockFills) {
+  PipeBuf pipe;
+  std::istream in(&pipe);
+  std::stop_source stop;
+  NdjsonOptions options{8 * 1024 * 1024, 2, true, std::chrono::milliseconds(5)};
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  uint64_t seen{};
+  RecordSum total{};
+  std::thread reader([&] {
+    total = sum_ndjson(
+        in, options,
+        [&](const RecordSum &running) {
+          std::lock_guard lock(mutex);
+          seen = running.count;
+          cv.notify_all();
+        },
+        stop.get_token());
+  });
+
+  pipe.write("{\"x0\": 0, \"y0\": 0, \"x1\": 1, \"y1\": 1}\n"
+             "{\"x0\": 10, \"y0\": 20, \"x1\": -30, \"y1\": 40}\n");
+  {
+    std::unique_lock lock(mutex);
+    EXPECT_TRUE(cv.wait_for(lock, std::chrono::seconds(5),
+                            [&] { return seen == 2; }));
+  }
+  stop.request_stop();
+  pipe.close();
+  reader.join();
+
+  EXPECT_EQ(total.count, 2);
+  EXPECT_DOUBLE_EQ(total.sum, haversine(0, 0, 1, 1, EARTH_RADIUS) +
+                                  haversine(10, 20, -30, 40, EARTH_RADIUS));
+}
@@ -157,3 +157,15 @@ TEST_F(ScannerTest, ComplexObject) {
   EXPECT_EQ(tokens[1].type, Token::String);
   EXPECT_EQ(std::get<std::string>(tokens[1].value), "string");
 }
+
+TEST_F(ScannerTest, ExponentNumbers) {
+  writeToFile(R"([-4.098696537369051e-05, 1E+3, 2e2])");
+  Scanner scanner(test_filename);
+  auto tokens = scanner.scan();
+
+  ASSERT_EQ(tokens.size(), 7);
+  EXPECT_EQ(tokens[1].type, Token::Double);
+  EXPECT_EQ(std::get<double>(tokens[1].value), -4.098696537369051e-05);
+  EXPECT_EQ(std::get<double>(tokens[3].value), 1000.0);
+  EXPECT_EQ(std::get<double>(tokens[5].value), 200.0);
+}
@@ -0,0 +1,118 @@
+#include "../src/haversine.hpp"
+#include "../src/server.hpp"
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <string>
+
+class ServerTest : public ::testing::Test {
+protected:
+  void SetUp() override { test_filename = "server_test.json"; }
+
+  void TearDown() override { std::remove(test_filename.c_str()); }
+
+  void writeToFile(const std::string &content) {
+    std::ofstream file(test_filename);
+    file << content;
+    file.close();
+  }
+
+  std::string test_filename;
+};
+
+TEST_F(ServerTest, SumLoadsOnceAndCaches) {
+  writeToFile(R"({"points": [{"x0": 0, "y0": 0, "x1": 1, "y1": 1},
+                             {"x0": 10, "y0": 20, "x1": -30, "y1": 40}]})");
+  auto sum = haversine(0, 0, 1, 1, EARTH_RADIUS) +
+             haversine(10, 20, -30, 40, EARTH_RADIUS);
+
+  DatasetCache cache;
+  auto response = handle_request(cache, "SUM " + test_filename);
+  EXPECT_EQ(response, std::format("OK 2 {} {}", sum, sum / 2));
+  EXPECT_EQ(handle_request(cache, "SUM " + test_filename), response);
+  EXPECT_EQ(cache.size(), 1);
+}
+
+TEST_F(ServerTest, ReloadsRewrittenFile) {
+  writeToFile(R"({"points": [{"x0": 0, "y0": 0, "x1": 1, "y1": 1}]})");
+  DatasetCache cache;
+  auto first = cache.get(test_filename);
+  EXPECT_EQ(first->total.count, 1);
+
+  writeToFile(R"({"points": [{"x0": 0, "y0": 0, "x1": 1, "y1": 1},
+                             {"x0": 0, "y0": 0, "x1": 2, "y1": 2}]})");
+  EXPECT_EQ(cache.get(test_filename)->total.count, 2);
+  EXPECT_EQ(cache.size(), 1);
+}
+
+TEST_F(ServerTest, EvictsLeastRecentlyUsed) {
+  writeToFile(R"({"points": []})");
+  std::filesystem::copy_file(test_filename, "server_test2.json",
+                             std::filesystem::copy_options::overwrite_existing);
+
+  DatasetCache cache(1);
+  auto a = cache.get(test_filename);
+  auto b = cache.get("server_test2.json");
+  EXPECT_EQ(cache.size(), 1);
+  EXPECT_NE(cache.get(test_filename), a);
+  std::remove("server_test2.json");
+}
+
+TEST_F(ServerTest, RadiusAndKnnQueries) {
+  writeToFile(R"({"points": [{"x0": 0, "y0": 0, "x1": 0, "y1": 1},
+                             {"x0": 90, "y0": 0, "x1": 0, "y1": 2}]})");
+  DatasetCache cache;
+  auto d1 = haversine(0, 0, 0, 1, EARTH_RADIUS);
+  auto d2 = haversine(0, 0, 0, 2, EARTH_RADIUS);
+
+  EXPECT_EQ(handle_request(cache, "RADIUS " + test_filename + " 0 0 150"),
+            std::format("OK 2 0:0 1:{}", d1));
+  EXPECT_EQ(handle_request(cache, "KNN " + test_filename + " 0 0 3"),
+            std::format("OK 3 0:0 1:{} 3:{}", d1, d2));
+  EXPECT_EQ(handle_request(cache, "KNN " + test_filename + " 0 0 4294967295")
+                .substr(0, 4),
+            "OK 4");
+  for (auto k : {"-1", "nan", "2.5", "4294967296"}) {
+    EXPECT_EQ(handle_request(cache, "KNN " + test_filename + " 0 0 " + k)
+                  .substr(0, 4),
+              "ERR ");
+  }
+}
+
+TEST_F(ServerTest, PairsBatch) {
+  DatasetCache cache;
+  EXPECT_EQ(handle_request(cache, "PAIRS 0 0 1 1 10 20 -30 40"),
+            std::format("OK {} {}", haversine(0, 0, 1, 1, EARTH_RADIUS),
+                        haversine(10, 20, -30, 40, EARTH_RADIUS)));
+}
+
+TEST_F(ServerTest, Errors) {
+  DatasetCache cache;
+  EXPECT_EQ(handle_request(cache, "").substr(0, 4), "ERR ");
+  EXPECT_EQ(handle_request(cache, "NOPE").substr(0, 4), "ERR ");
+  EXPECT_EQ(handle_request(cache, "PAIRS 0 0 1").substr(0, 4), "ERR ");
+  EXPECT_EQ(handle_request(cache, "PAIRS 0 0 1 x").substr(0, 4), "ERR ");
+  EXPECT_EQ(handle_request(cache, "SUM missing.json").substr(0, 4), "ERR ");
+
+  writeToFile(R"({"points": [{"x0": 0, "y0": )");
+  EXPECT_EQ(handle_request(cache, "SUM " + test_filename).substr(0, 4),
+            "ERR ");
+  EXPECT_EQ(cache.size(), 0);
+}
+
+TEST_F(ServerTest, FileCaughtMidWrite) {
+  writeToFile(R"({"points": [{"x0": 0, "y)");
+  DatasetCache cache;
+  EXPECT_EQ(handle_request(cache, "SUM " + test_filename),
+            "ERR Unterminated string");
+  EXPECT_EQ(cache.size(), 0);
+}
+
+TEST_F(ServerTest, FileCutAfterValue) {
+  writeToFile(R"({"points": [{"x0":1,"y0":2,"x1":3,"y1":4}, {"x0": 0)");
+  DatasetCache cache;
+  EXPECT_EQ(handle_request(cache, "SUM " + test_filename).substr(0, 4),
+            "ERR ");
+  EXPECT_EQ(cache.size(), 0);
+}
@@ -0,0 +1,152 @@
+#include "../src/spatial_index.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+class SpatialIndexTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<double> lon(-180, 180);
+    std::uniform_real_distribution<double> lat(-90, 90);
+    for (int i = 0; i < 5000; i++) {
+      points.push_back({lon(gen), lat(gen)});
+    }
+    for (int i = 0; i < 20; i++) {
+      centers.push_back({lon(gen), lat(gen)});
+    }
+    index_filename = "test.idx";
+  }
+
+  void TearDown() override { std::remove(index_filename.c_str()); }
+
+  auto brute_force(GeoPoint center) const -> std::vector<double> {
+    std::vector<double> distances;
+    for (auto &p : points) {
+      distances.push_back(
+          haversine(center.x, center.y, p.x, p.y, EARTH_RADIUS));
+    }
+    std::sort(distances.begin(), distances.end());
+    return distances;
+  }
+
+  std::vector<GeoPoint> points;
+  std::vector<GeoPoint> centers;
+  std::string index_filename;
+};
+
+TEST_F(SpatialIndexTest, EmptyIndex) {
+  SpatialIndex index(std::vector<GeoPoint>{});
+  EXPECT_EQ(index.size(), 0);
+  EXPECT_TRUE(index.radius_query(GeoPoint{0, 0}, 1000).empty());
+  EXPECT_TRUE(index.knn_query(GeoPoint{0, 0}, 3).empty());
+}
+
+TEST_F(SpatialIndexTest, RadiusMatchesBruteForce) {
+  SpatialIndex index(points);
+  for (auto center : centers) {
+    auto expected = brute_force(center);
+    auto hits = index.radius_query(center, 1500);
+    auto count = std::upper_bound(expected.begin(), expected.end(), 1500) -
+                 expected.begin();
+    ASSERT_EQ(hits.size(), count);
+    for (size_t i = 0; i < hits.size(); i++) {
+      EXPECT_EQ(hits[i].distance, expected[i]);
+    }
+  }
+}
+
+TEST_F(SpatialIndexTest, RadiusCoveringWholeSphere) {
+  SpatialIndex index(points);
+  EXPECT_EQ(index.radius_query(centers[0], 30000).size(), points.size());
+}
+
+TEST_F(SpatialIndexTest, KnnMatchesBruteForce) {
+  SpatialIndex index(points);
+  auto results = index.knn_query(centers, 7);
+  ASSERT_EQ(results.size(), centers.size());
+  for (size_t c = 0; c < centers.size(); c++) {
+    auto expected = brute_force(centers[c]);
+    ASSERT_EQ(results[c].size(), 7);
+    for (size_t i = 0; i < 7; i++) {
+      EXPECT_EQ(results[c][i].distance, expected[i]);
+      auto &p = points[results[c][i].id];
+      EXPECT_EQ(haversine(centers[c].x, centers[c].y, p.x, p.y, EARTH_RADIUS),
+                expected[i]);
+    }
+  }
+}
+
+TEST_F(SpatialIndexTest, KnnWithFewerPointsThanRequested) {
+  SpatialIndex index(std::vector<GeoPoint>{{0, 0}, {1, 1}});
+  auto hits = index.knn_query(GeoPoint{0, 0}, 5);
+  ASSERT_EQ(hits.size(), 2);
+  EXPECT_EQ(hits[0].id, 0);
+  EXPECT_EQ(hits[1].id, 1);
+}
+
+TEST_F(SpatialIndexTest, SaveAndLoad) {
+  SpatialIndex index(points);
+  index.save(index_filename);
+  auto loaded = SpatialIndex::load(index_filename);
+
+  ASSERT_EQ(loaded.size(), index.size());
+  auto a = index.knn_query(centers[3], 5);
+  auto b = loaded.knn_query(centers[3], 5);
+  ASSERT_EQ(a.size(), b.size());
+  for (size_t i = 0; i < a.size(); i++) {
+    EXPECT_EQ(a[i].id, b[i].id);
+    EXPECT_EQ(a[i].distance, b[i].distance);
+  }
+}
+
+TEST_F(SpatialIndexTest, LoadRejectsGarbage) {
+  {
+    std::ofstream f(index_filename);
+    f << "{\"points\": []}";
+  }
+  EXPECT_THROW(SpatialIndex::load(index_filename), std::runtime_error);
+}
+
+TEST_F(SpatialIndexTest, LoadRejectsCorruptIndex) {
+  SpatialIndex(std::vector<GeoPoint>{{0, 0}, {1, 1}, {2, 2}})
+      .save(index_filename);
+  std::string original;
+  {
+    std::ifstream f(index_filename, std::ios::binary);
+    original.assign(std::istreambuf_iterator<char>(f), {});
+  }
+  auto write = [&](const std::string &bytes) {
+    std::ofstream f(index_filename, std::ios::binary | std::ios::trunc);
+    f << bytes;
+  };
+  // Header: magic, version, count, radius; then the node array.
+  constexpr size_t count_offset = 8;
+  constexpr size_t nodes_offset = 24;
+
+  write(original.substr(0, original.size() - 1));
+  EXPECT_THROW(SpatialIndex::load(index_filename), std::runtime_error);
+
+  auto huge_count = original;
+  uint64_t count = uint64_t{1} << 60;
+  std::memcpy(huge_count.data() + count_offset, &count, sizeof(count));
+  write(huge_count);
+  EXPECT_THROW(SpatialIndex::load(index_filename), std::runtime_error);
+
+  auto bad_axis = original;
+  uint32_t axis = 7;
+  std::memcpy(bad_axis.data() + nodes_offset +
+                  offsetof(SpatialIndex::Node, axis),
+              &axis, sizeof(axis));
+  write(bad_axis);
+  EXPECT_THROW(SpatialIndex::load(index_filename), std::runtime_error);
+
+  write(original);
+  EXPECT_EQ(SpatialIndex::load(index_filename).size(), 3);
+}